@@ -30,7 +30,18 @@ cas_extension = Extension('channel_access.server.cas',
         'server.cpp',
         'pv.cpp',
         'convert.cpp',
-        'async.cpp'
+        'async.cpp',
+        'registry.cpp',
+        'search_cache.cpp',
+        'router.cpp',
+        'shard_map.cpp',
+        'attributes.cpp',
+        'kernels.cpp',
+        'limits.cpp',
+        'rate_limiter.cpp',
+        'frame_publisher.cpp',
+        'event_queue.cpp',
+        'server_thread.cpp'
     ])),
     include_dirs = [
         cas_path,
@@ -1,3 +1,8 @@
+import asyncio
+import atexit
+import concurrent.futures
+import socket
+import struct
 import threading
 import weakref
 from datetime import datetime, timedelta, timezone
@@ -13,23 +18,6 @@ else:
     numpy = None
 
 
-try:
-    from math import isclose as _isclose
-except ImportError:
-    # implement our own according to the python source
-    def _isclose(a, b, *, rel_tol=1e-09, abs_tol=0.0):
-        import math
-
-        if rel_tol < 0.0 or abs_tol < 0.0:
-            raise ValueError('tolerances must be non-negative')
-        if a == b:
-            return True
-        if math.isinf(a) or math.isinf(b):
-            return False
-        diff = abs(a - b)
-        return diff <= abs(rel_tol * b) or diff <= abs(rel_tol * a) or diff < abs_tol
-
-
 def is_sequence(value):
     """
     Return ``True`` if ``value`` is a sequence type.
@@ -100,10 +88,17 @@ class AsyncRead(cas.AsyncRead):
 
     When the read operation is completed call the :meth:`complete`
     method. If it fails call the :meth:`fail` method.
+
+    The object is awaitable, awaiting it returns ``True`` after
+    :meth:`complete` and ``False`` after :meth:`fail` was called.
     """
     def __init__(self, pv, context):
         super().__init__(context)
         self._pv = pv
+        self._done = concurrent.futures.Future()
+
+    def __await__(self):
+        return asyncio.wrap_future(self._done).__await__()
 
     def complete(self, attributes):
         """
@@ -121,8 +116,9 @@ class AsyncRead(cas.AsyncRead):
         pv = self._pv
         with pv._attributes_lock:
             pv._update_attributes(attributes)
-            attributes = pv._copy_attributes()
+            attributes = pv._copy_attributes(read_only=True)
         super().complete(pv._pv._encode(attributes))
+        _set_done(self._done, True)
 
     def fail(self):
         """
@@ -133,6 +129,7 @@ class AsyncRead(cas.AsyncRead):
         This method is thread-safe.
         """
         super().fail()
+        _set_done(self._done, False)
 
 
 class AsyncWrite(cas.AsyncWrite):
@@ -144,10 +141,17 @@ class AsyncWrite(cas.AsyncWrite):
 
     When the write operation is completed call the :meth:`complete`
     method. If it fails call the :meth:`fail` method.
+
+    The object is awaitable, awaiting it returns ``True`` after
+    :meth:`complete` and ``False`` after :meth:`fail` was called.
     """
     def __init__(self, pv, context):
         super().__init__(context)
         self._pv = pv
+        self._done = concurrent.futures.Future()
+
+    def __await__(self):
+        return asyncio.wrap_future(self._done).__await__()
 
     def complete(self, value, timestamp=None):
         """
@@ -166,6 +170,7 @@ class AsyncWrite(cas.AsyncWrite):
             timestamp = datetime.now(timezone.utc)
         self._pv._update_value_timestamp(value, timestamp)
         super().complete()
+        _set_done(self._done, True)
 
     def fail(self):
         """
@@ -176,6 +181,154 @@ class AsyncWrite(cas.AsyncWrite):
         This method is thread-safe.
         """
         super().fail()
+        _set_done(self._done, False)
+
+
+class AsyncPVExist(cas.AsyncPVExist):
+    """
+    Asyncronous exist test completion class.
+
+    Create an object of this class in an exist handler and return it
+    to signal an asynchronous exist test.
+
+    When the result is known call the :meth:`complete`
+    method. If it fails call the :meth:`fail` method.
+    """
+    def __init__(self, server, context):
+        super().__init__(context)
+        self._server = server
+
+    def complete(self, exists):
+        """
+        Complete the asynchronous exist test.
+
+        This method is thread-safe.
+
+        Args:
+            exists (bool|tuple): ``True`` if the PV exists on this server,
+                ``False`` otherwise. A tuple ``(ip, port)`` redirects the
+                client to another server.
+        """
+        super().complete(_to_exists_response(exists))
+
+    def fail(self):
+        """
+        Fail the asynchronous exist test.
+
+        The PV is reported as not existing on this server.
+
+        This method is thread-safe.
+        """
+        super().fail()
+
+
+class AsyncPVAttach(cas.AsyncPVAttach):
+    """
+    Asyncronous attach completion class.
+
+    Create an object of this class in an attach handler and return it
+    to signal an asynchronous attach.
+
+    When the PV is available call the :meth:`complete`
+    method. If it fails call the :meth:`fail` method.
+    """
+    def __init__(self, server, context):
+        super().__init__(context)
+        self._server = server
+
+    def complete(self, pv):
+        """
+        Complete the asynchronous attach.
+
+        This method is thread-safe.
+
+        Args:
+            pv (:class:`PV`): The PV for the requested name or ``None``
+                if it does not exist.
+        """
+        if pv is None:
+            super().fail()
+        else:
+            super().complete(pv._pv)
+
+    def fail(self):
+        """
+        Fail the asynchronous attach.
+
+        The PV is reported as not found.
+
+        This method is thread-safe.
+        """
+        super().fail()
+
+
+def _set_done(future, result):
+    """ Set the result of a completion future unless it is already done. """
+    if not future.done():
+        future.set_result(result)
+
+
+async def _complete_read(coroutine, completion):
+    """ Complete an asynchronous read with the result of a coroutine read handler. """
+    try:
+        result = await coroutine
+    except BaseException:
+        completion.fail()
+        raise
+    if isinstance(result, AsyncRead):
+        # The context is only valid while the handler is called, an
+        # object created by the coroutine can not answer the request.
+        # Fail it instead of letting the client wait.
+        completion.fail()
+        raise TypeError('Coroutine handlers can not return AsyncRead objects')
+    if not result:
+        completion.fail()
+    elif result is True:
+        completion.complete({})
+    else:
+        completion.complete(result)
+
+
+async def _complete_write(coroutine, completion, value, timestamp):
+    """ Complete an asynchronous write with the result of a coroutine write handler. """
+    try:
+        result = await coroutine
+    except BaseException:
+        completion.fail()
+        raise
+    if isinstance(result, AsyncWrite):
+        # The context is only valid while the handler is called, an
+        # object created by the coroutine can not answer the request.
+        # Fail it instead of letting the client wait.
+        completion.fail()
+        raise TypeError('Coroutine handlers can not return AsyncWrite objects')
+    if not result:
+        completion.fail()
+    elif result is True:
+        completion.complete(value, timestamp)
+    else:
+        completion.complete(*result)
+
+
+def _to_address(address):
+    """ Convert an ``(ip, port)`` tuple to the low-level representation. """
+    host, port = address
+    if isinstance(host, str):
+        host = struct.unpack('!I', socket.inet_aton(host))[0]
+    return (host, port)
+
+
+def _to_exists_response(result):
+    """ Convert the result of an exist handler to an ExistsResponse. """
+    if isinstance(result, AsyncPVExist) or isinstance(result, ExistsResponse):
+        return result
+    if result is True:
+        return ExistsResponse.EXISTS_HERE
+    if result is False:
+        return ExistsResponse.NOT_EXISTS_HERE
+    if isinstance(result, tuple) and len(result) == 2:
+        return _to_address(result)
+    raise TypeError('Exist handlers must return a bool, an (ip, port) tuple or an AsyncPVExist object')
 
 
 class PV(object):
@@ -257,6 +410,10 @@ class PV(object):
             * ``False`` to disallow the read.
             * An attributes dictionary to update the attributes and use them.
             * An :class:`AsyncRead` object to signal an asynchronous read operation.
+            * A coroutine, e.g. from an ``async def`` handler. It is run on
+              the ``loop`` of the PV as an asynchronous read operation and
+              its result, one of the above except an :class:`AsyncRead`
+              object, completes it.
 
     A write handler allows to customize the change of the PV value
     via channel access and perform asynchronous writes.
@@ -276,11 +433,16 @@ class PV(object):
             * ``False`` to disallow the write.
             * A tuple ``(value, timestamp)`` to use instead of the arguments.
             * An :class:`AsyncWrite` object to signal an asynchronous write operation.
+            * A coroutine, e.g. from an ``async def`` handler. It is run on
+              the ``loop`` of the PV as an asynchronous write operation and
+              its result, one of the above except an :class:`AsyncWrite`
+              object, completes it.
     """
     def __init__(self, name, type_, *, count=None, attributes=None,
             value_deadband=0, archive_deadband=0,
             read_handler=None, write_handler=None, read_only=False,
-            encoding='utf-8', monitor=None, use_numpy=None):
+            encoding='utf-8', monitor=None, use_numpy=None, numpy_views=False,
+            max_event_rate=None, loop=None):
         """
         Args:
             name (str|bytes): Name of the PV.
@@ -308,6 +470,13 @@ class PV(object):
                 attributes. If ``None`` these values must be bytes.
             use_numpy (bool): If ``True`` use numpy arrays. If ``None``
                 use numpy arrays if numpy support is available.
+            numpy_views (bool): If ``True`` array values of put requests
+                are read-only numpy arrays referencing the request data
+                instead of copies. Only used with ``use_numpy``.
+            max_event_rate (int|float): If set, at most this many events
+                per second are posted, see :attr:`max_event_rate`.
+            loop (:class:`asyncio.AbstractEventLoop`): The event loop
+                running coroutines returned by the read and write handlers.
         """
         super().__init__()
         if use_numpy is None:
@@ -315,7 +484,10 @@ class PV(object):
         if read_only and not write_handler:
             write_handler = failing_write_handler
         self._pv = _PV(name, self, use_numpy=use_numpy, encoding=encoding,
-            read_handler=read_handler, write_handler=write_handler)
+            read_handler=read_handler, write_handler=write_handler, loop=loop)
+        self._pv.numpy_views = numpy_views
+        if max_event_rate:
+            self._pv.setMaxEventRate(max_event_rate)
 
         self._name = name
         self._type = type_
@@ -328,12 +500,26 @@ class PV(object):
         self._attributes_lock = threading.Lock()
         self._monitor_handler = monitor
         self._outstanding_events = ca.Events.NONE
+        # Weak reference to the server when publishing in frames
+        self._frame_publisher = None
         self._publish_events = False
+        # Without read handler reads are served from the native store
+        self._use_store = read_handler is None
+        # Set when the stored meta data has to be converted again, unlike
+        # Events.PROPERTY not for timestamp changes
+        self._metadata_changed = False
         self._attributes = default_attributes(type_, count, use_numpy)
 
         if attributes is not None:
             self._update_attributes(attributes)
 
+        encoded_attributes = self._pv._encode(self._copy_attributes(read_only=True))
+        if self._use_store:
+            self._pv.storeAttributes(encoded_attributes)
+        else:
+            self._pv.storeMetadata(encoded_attributes)
+        self._metadata_changed = False
+
     # only call with attributes lock held
     def _update_status_severity(self, status, severity):
         """ Update the status and serverity. """
@@ -348,136 +534,50 @@ class PV(object):
             self._outstanding_events |= ca.Events.ALARM
 
     # only call with attributes lock held
-    def _constrain_value(self, value):
-        """ Constrain a value to the control limits range. """
-        if self._type != ca.Type.STRING:
-            ctrl_limits = self._attributes.get('control_limits')
-
-            if ctrl_limits is not None and ctrl_limits[0] < ctrl_limits[1]:
-                clamp = lambda v: max(min(v, ctrl_limits[1]), ctrl_limits[0])
-                if is_sequence(value):
-                    return tuple(map(clamp, value))
-                else:
-                    return clamp(value)
-        return value
-
-    # only call with attributes lock held
-    def _calculate_status_severity(self, value):
-        """ Calculate status and severity values using warning and alarm limits. """
-        status = ca.Status.NO_ALARM
-        severity = ca.Severity.NO_ALARM
-        if self._type != ca.Type.STRING:
-            alarm_limits = self._attributes.get('alarm_limits')
-            warn_limits = self._attributes.get('warning_limits')
-
-            if is_sequence(value):
-                # For arrays use the extreme values
-                lowest = min(value)
-                highest = max(value)
-            else:
-                lowest = value
-                highest = value
-
-            if warn_limits is not None and warn_limits[0] < warn_limits[1]:
-                if lowest < warn_limits[0] and highest > warn_limits[1]:
-                    # If both limits are violated (can happen in arrays)
-                    # the violation with the highest absolute difference
-                    # is used
-                    if abs(lowest - warn_limits[0]) > abs(highest - warn_limits[1]):
-                        severity = ca.Severity.MINOR
-                        status = ca.Status.LOW
-                    else:
-                        severity = ca.Severity.MINOR
-                        status = ca.Status.HIGH
-                elif lowest < warn_limits[0]:
-                    severity = ca.Severity.MINOR
-                    status = ca.Status.LOW
-                elif highest > warn_limits[1]:
-                    severity = ca.Severity.MINOR
-                    status = ca.Status.HIGH
-
-            if alarm_limits is not None and alarm_limits[0] < alarm_limits[1]:
-                if lowest < alarm_limits[0] and highest > alarm_limits[1]:
-                    # If both limits are violated (can happen in arrays)
-                    # the violation with the highest absolute difference
-                    # is used
-                    if abs(lowest - alarm_limits[0]) > abs(highest - alarm_limits[1]):
-                        severity = ca.Severity.MAJOR
-                        status = ca.Status.LOLO
-                    else:
-                        severity = ca.Severity.MAJOR
-                        status = ca.Status.HIHI
-                elif lowest < alarm_limits[0]:
-                    severity = ca.Severity.MAJOR
-                    status = ca.Status.LOLO
-                elif highest > alarm_limits[1]:
-                    severity = ca.Severity.MAJOR
-                    status = ca.Status.HIHI
-        return status, severity
+    def _apply_limits(self, value):
+        """
+        Constrain a value to the control limits range and calculate
+        status and severity values using warning and alarm limits.
+        """
+        if self._type == ca.Type.STRING:
+            return value, ca.Status.NO_ALARM, ca.Severity.NO_ALARM
+        return cas.applyLimits(value,
+            self._attributes.get('control_limits'),
+            self._attributes.get('warning_limits'),
+            self._attributes.get('alarm_limits'))
 
     # only call with attributes lock held
     def _update_value(self, value):
         """ Update the value and depending on it the status and severity. """
-        value = self._constrain_value(value)
-        status, severity = self._calculate_status_severity(value)
+        value, status, severity = self._apply_limits(value)
 
         old_value = self._attributes.get('value')
-        if is_sequence(value) != is_sequence(old_value):
-            # If old and new_value differ in wether they are sequences or not
-            # we can't compare them.
-            value_changed = True
-        elif is_sequence(value) and len(value) != len(old_value):
-            # If the lenth of both sequences are different we can't
-            # compare them either.
-            value_changed = True
+        if is_sequence(value) != is_sequence(old_value) or (is_sequence(value) and len(value) != len(old_value)):
+            # If old and new_value differ in wether they are sequences or
+            # not or in their length we can't compare them.
+            self._attributes['value'] = value
+            self._pv.invalidateTypeInfo()
+            self._outstanding_events |= ca.Events.VALUE | ca.Events.ARCHIVE
+        elif self._type == ca.Type.STRING:
+            if value != old_value:
+                self._attributes['value'] = value
+                self._outstanding_events |= ca.Events.VALUE | ca.Events.ARCHIVE
         else:
+            # Floating point types can't be compared with the equal
+            # operator because of rounding errors, integers are compared
+            # exactly. Deadbands are only defined for number types.
             if self._type in (ca.Type.FLOAT, ca.Type.DOUBLE):
-                # Floating point types can't be compare with the equal
-                # operator because of rounding errors
-                isclose = lambda a, b: _isclose(a, b, rel_tol=self._relative_tolerance, abs_tol=self._absolute_tolerance)
-                if is_sequence(value):
-                    # sequences are compared element-wise
-                    if numpy and (isinstance(value, numpy.ndarray) or isinstance(old_value, numpy.ndarray)):
-                        value_changed = not numpy.allclose(value, old_value, rtol=self._relative_tolerance, atol=self._absolute_tolerance)
-                    else:
-                        value_changed = not all(map(lambda x: isclose(x[0], x[1]), zip(value, old_value)))
-                else:
-                    value_changed = not isclose(value, old_value)
+                tolerances = (self._relative_tolerance, self._absolute_tolerance)
             else:
-                # Integer types are compared with the equal operator
-                if numpy and (isinstance(value, numpy.ndarray) or isinstance(old_value, numpy.ndarray)):
-                    value_changed = not numpy.all(numpy.equal(value, old_value))
-                else:
-                    # For simple sequences this compares element-wise
-                    value_changed = value != old_value
-
-        if value_changed:
-            self._attributes['value'] = value
-
-            # Deadbands are only defined for number types
-            check_deadbands = self._type not in (ca.Type.STRING, ca.Type.ENUM)
-            if is_sequence(value) != is_sequence(old_value):
-                # If the values differ in wether they are sequences or not,
-                # deadbands can't be used.
-                check_deadbands = False
-            elif is_sequence(value) and len(value) != len(old_value):
-                # If the lenth of both sequences are different we can't
-                # use the deadbands either.
-                check_deadbands = False
-
-            if check_deadbands:
-                if is_sequence(value):
-                    # Look at the maximum difference between the old values
-                    # and the new ones.
-                    diff = max(map(lambda x: abs(x[0] - x[1]), zip(value, old_value)))
-                else:
-                    diff = abs(value - old_value)
-                if diff >= self._value_deadband:
-                    self._outstanding_events |= ca.Events.VALUE
-                if diff >= self._archive_deadband:
-                    self._outstanding_events |= ca.Events.ARCHIVE
+                tolerances = (0.0, 0.0)
+            if self._type == ca.Type.ENUM:
+                deadbands = (0.0, 0.0)
             else:
-                self._outstanding_events |= ca.Events.VALUE | ca.Events.ARCHIVE
+                deadbands = (self._value_deadband, self._archive_deadband)
+            value_changed, events = cas.valueEvents(value, old_value, *tolerances, *deadbands)
+            if value_changed:
+                self._attributes['value'] = value
+                self._outstanding_events |= ca.Events(events)
 
         self._update_status_severity(status, severity)
 
@@ -487,6 +587,8 @@ class PV(object):
         if value != self._attributes.get(key):
             self._attributes[key] = value
             self._outstanding_events |= ca.Events.PROPERTY
+            if key != 'timestamp':
+                self._metadata_changed = True
         if key.endswith('_limits'):
             # If the limits change we might need to change the value accordingly
             self._update_value(self._attributes.get('value'))
@@ -499,6 +601,8 @@ class PV(object):
             if key in attributes and attributes[key] != self._attributes.get(key):
                 self._attributes[key] = attributes[key]
                 self._outstanding_events |= ca.Events.PROPERTY
+                if key != 'timestamp':
+                    self._metadata_changed = True
                 if key.endswith('_limits'):
                     limits_changed = True
 
@@ -521,40 +625,96 @@ class PV(object):
             # If the limits change we might need to change the value accordingly
             self._update_value(self._attributes.get('value'))
 
+    # only call with attributes lock held
+    def _prepare_publish(self, update_store=True):
+        """
+        Update the store and return the events to post.
+
+        Returns ``None`` if nothing changed, otherwise a tuple
+        ``(events, attributes, encoded_attributes)``. ``encoded_attributes``
+        is ``None`` if no events have to be posted.
+        """
+        events = self._outstanding_events
+        self._outstanding_events = ca.Events.NONE
+        if events == ca.Events.NONE:
+            return None
+
+        # We need a copy here for thread-safety. This method can
+        # be called concurrently multiple times and because we
+        # release the lock when posting the atomicity of this
+        # call is not ensured without a copy.
+        attributes = self._copy_attributes(read_only=True)
+        store = update_store and (self._use_store or self._metadata_changed)
+        encoded_attributes = None
+        if store or self._publish_events:
+            encoded_attributes = self._pv._encode(attributes.copy())
+        # Update the store with the lock held so the updates
+        # are stored in order.
+        if store:
+            self._update_store(encoded_attributes)
+
+        if not self._publish_events:
+            encoded_attributes = None
+        return (events, attributes, encoded_attributes)
+
+    # only call with attributes lock held
+    def _update_store(self, encoded_attributes):
+        """
+        Update the native store with the encoded attributes.
+
+        The value, status, severity and timestamp are converted on every
+        update, even if no client reads them, so that reads never need
+        the GIL. The meta data is only converted again if it changed.
+        """
+        if self._use_store:
+            self._pv.storeAttributes(encoded_attributes, self._metadata_changed)
+        elif self._metadata_changed:
+            self._pv.storeMetadata(encoded_attributes)
+        self._metadata_changed = False
+
     # only call with attributes lock held
     def _publish(self):
         """ Post events if necessary. """
-        events = self._outstanding_events
-        publish_events = self._publish_events
+        # In frame mode the events accumulate until the server
+        # publishes the next frame. Reads must not wait for it,
+        # the store is updated right away.
+        publisher = self._frame_publisher
+        if publisher is not None and self._outstanding_events != ca.Events.NONE:
+            server = publisher()
+            if server is not None and server.markDirty(self):
+                if self._use_store or self._metadata_changed:
+                    self._update_store(self._pv._encode(self._copy_attributes(read_only=True)))
+                return
+
         monitor_handler = self._monitor_handler
-        self._outstanding_events = ca.Events.NONE
-        if events != ca.Events.NONE:
-            # We need a copy here for thread-safety. This method can
-            # be called concurrently multiple times and because we
-            # release the lock when posting the atomicity of this
-            # call is not ensured without a copy.
-            attributes = self._copy_attributes()
+        publish = self._prepare_publish()
+        if publish is not None:
+            events, attributes, encoded_attributes = publish
 
             # Release attributes lock during calls to prevent deadlock
             # when a method which changes the attributes is called.
             self._attributes_lock.release()
             try:
-                if publish_events:
-                    self._pv.postEvents(events, attributes)
+                if encoded_attributes is not None:
+                    self._pv.postEvent(events, encoded_attributes)
                 if monitor_handler:
                     monitor_handler(self, attributes)
             finally:
                 self._attributes_lock.acquire()
 
     # only call with attributes lock held
-    def _copy_attributes(self):
+    def _copy_attributes(self, read_only=False):
         # All keys and values are immutable so a shallow copy is enough.
         attributes = self._attributes.copy()
         # If the value is a numpy array whe have to create a copy
-        # because numpy arrays are not immutable.
+        # because numpy arrays are not immutable. A read-only copy is
+        # referenced by the server instead of being copied again.
         value = attributes.get('value')
         if numpy and isinstance(value, numpy.ndarray):
-            attributes['value'] = numpy.copy(value)
+            value = numpy.copy(value)
+            if read_only:
+                value.flags.writeable = False
+            attributes['value'] = value
         return attributes
 
     # only call with attributes lock held
@@ -590,6 +750,39 @@ class PV(object):
         """
         return self._pv.use_numpy
 
+    @property
+    def max_event_rate(self):
+        """
+        float: Maximum number of events per second posted for this PV,
+        ``0`` if not limited.
+
+        Updates arriving faster are conflated: only the latest values
+        are posted, together with all pending events, when the limit
+        allows it. This is useful when a PV changes faster than clients
+        can use the updates.
+
+        This is writeable and changes the limit. Set it to ``0`` to
+        disable the limit.
+        """
+        return self._pv.maxEventRate()
+
+    @max_event_rate.setter
+    def max_event_rate(self, value):
+        self._pv.setMaxEventRate(value or 0)
+
+    @property
+    def event_statistics(self):
+        """
+        Return statistics of the event rate limit.
+
+        This property is thread-safe.
+
+        Returns:
+            dict: A dictionary with the keys ``conflated`` and ``dropped``.
+            See :meth:`cas.PV.eventStatistics`.
+        """
+        return self._pv.eventStatistics()
+
     @property
     def is_array(self):
         """
@@ -644,6 +837,7 @@ class PV(object):
             * **pv** (:class:`PV`): The :class:`PV` object with the
               changed values.
             * **attributes** (dict): A attributes dictionary with the new attributes.
+              Numpy arrays in it are read-only.
         """
         with self._attributes_lock:
             return self._monitor_handler
@@ -667,6 +861,7 @@ class PV(object):
     def attributes(self, attributes):
         with self._attributes_lock:
             self._update_attributes(attributes)
+            self._publish()
 
     @property
     def timestamp(self):
@@ -876,7 +1071,7 @@ class _PV(cas.PV):
     """
     cas.PV implementation.
     """
-    def __init__(self, name, pv, *, use_numpy, encoding, read_handler, write_handler):
+    def __init__(self, name, pv, *, use_numpy, encoding, read_handler, write_handler, loop):
         if encoding is not None:
             name = name.encode(encoding)
         super().__init__(name, use_numpy)
@@ -884,9 +1079,16 @@ class _PV(cas.PV):
         self._encoding = encoding
         self._read_handler = read_handler
         self._write_handler = write_handler
+        self._loop = loop
+
+    def _check_loop(self, coroutine):
+        """ Raise if there is no event loop to run a handler coroutine. """
+        if self._loop is None:
+            coroutine.close()
+            raise RuntimeError('Coroutine handlers need the loop parameter')
 
     def _encode(self, attributes):
-        """ Convert a high-level attributes dictionary to a low-level one. """
+        """ Convert a high-level attributes dictionary to a low-level attributes object. """
         if self._encoding is not None:
             if 'unit' in attributes:
                 attributes['unit'] = attributes['unit'].encode(self._encoding)
@@ -897,10 +1099,8 @@ class _PV(cas.PV):
             if 'value' in attributes and self._pv.type == ca.Type.STRING:
                 attributes['value'] = attributes['value'].encode(self._encoding)
 
-        if 'timestamp' in attributes:
-            attributes['timestamp'] = ca.datetime_to_epics(attributes['timestamp'])
-
-        return attributes
+        # The timestamp is converted natively
+        return cas.Attributes(**attributes)
 
     def _decode(self, value, timestamp=None):
         """ Convert a low-level value and timestamp to high-level ones. """
@@ -922,17 +1122,23 @@ class _PV(cas.PV):
         attributes = None
         if self._read_handler:
             result = self._read_handler(self._pv, context)
+            if asyncio.iscoroutine(result):
+                self._check_loop(result)
+                completion = AsyncRead(self._pv, context)
+                asyncio.run_coroutine_threadsafe(_complete_read(result, completion), self._loop)
+                return completion
             if isinstance(result, AsyncRead) or not result:
                 return result
             # Test for the True singleton
             if result is not True:
                 with self._pv._attributes_lock:
                     self._pv._update_attributes(result)
-                    attributes = self._pv._copy_attributes()
+                    attributes = self._encode(self._pv._copy_attributes(read_only=True))
+                    if self._pv._metadata_changed:
+                        self._pv._update_store(attributes)
+                return attributes
 
-        if not attributes:
-            attributes = self._pv.attributes
-        return self._encode(attributes)
+        return self._encode(self._pv.attributes)
 
     def write(self, value, timestamp, context):
         value, timestamp = self._decode(value, timestamp)
@@ -940,6 +1146,11 @@ class _PV(cas.PV):
         if self._write_handler:
             result = self._write_handler(self._pv, value, timestamp, context)
 
+            if asyncio.iscoroutine(result):
+                self._check_loop(result)
+                completion = AsyncWrite(self._pv, context)
+                asyncio.run_coroutine_threadsafe(_complete_write(result, completion, value, timestamp), self._loop)
+                return completion
             if isinstance(result, AsyncWrite) or not result:
                 return result
             # Test for the True singleton
@@ -960,9 +1171,6 @@ class _PV(cas.PV):
     def interestDelete(self):
         self._pv._set_publish_events(False)
 
-    def postEvents(self, events, attributes):
-        self.postEvent(events, self._encode(attributes))
-
 
 _sentinal = object()
 
@@ -980,8 +1188,50 @@ class Server(object):
 
         with cas.Server() as server:
             pass
+
+    Names which are neither PVs nor aliases are passed to the exist and
+    attach handlers. This allows creating PVs on demand. The handlers are
+    called from an unspecified thread and should not block, use
+    :class:`AsyncPVExist` and :class:`AsyncPVAttach` for slow lookups.
+
+    The names are decoded with the ``encoding`` parameter (``utf-8`` if
+    it is ``None``).
+
+    An exist handler tells the server wether a PV exists. Unknown names
+    are remembered in the negative search cache, call
+    :meth:`clearSearchCache()` if the answer for a name changes.
+
+        **Signature**: ``exist_handler(server, name, context)``
+
+        **Parameters**:
+
+            * **server** (:class:`Server`): This server.
+            * **name** (str): The requested name.
+            * **context** : A context object needed to create an :class:`AsyncPVExist` object.
+
+        **Returns**:
+            * ``True`` if the PV exists, ``False`` otherwise.
+            * A tuple ``(ip, port)`` to redirect the client to another server.
+            * An :class:`AsyncPVExist` object to signal an asynchronous exist test.
+
+    An attach handler returns the PV object when a client connects.
+
+        **Signature**: ``attach_handler(server, name, context)``
+
+        **Parameters**:
+
+            * **server** (:class:`Server`): This server.
+            * **name** (str): The requested name.
+            * **context** : A context object needed to create an :class:`AsyncPVAttach` object.
+
+        **Returns**:
+            * A :class:`PV` object, typically created with :meth:`createPV`.
+            * ``None`` if the PV does not exist.
+            * An :class:`AsyncPVAttach` object to signal an asynchronous attach.
     """
-    def __init__(self, *, encoding=None, use_numpy=None):
+    def __init__(self, *, encoding=None, use_numpy=None, search_cache=100000,
+            route_cache=1000, exist_handler=None, attach_handler=None,
+            publish_rate=None, event_queue=None, loop=None):
         """
         Args:
             encoding (str): If not ``None`` this value is used as a
@@ -990,21 +1240,43 @@ class Server(object):
             use_numpy (bool): If not ``None`` this value is used as a
                 default for the ``use_numpy`` parameter when
                 calling :meth:`createPV`.
+            search_cache (int): Number of unknown names remembered
+                to answer repeated searches for PVs hosted on other
+                servers without a lookup. ``0`` disables the cache.
+            route_cache (int): Number of PVs created by route factories
+                which are kept alive. See :meth:`addRoute`.
+            exist_handler (callable): Initial value for the exist handler.
+            attach_handler (callable): Initial value for the attach handler.
+            publish_rate (int|float): If set, events of PVs created with
+                :meth:`createPV` are published in frames,
+                see :attr:`publish_rate`.
+            event_queue (int): If set, events posted from other threads
+                are queued with this capacity and posted by the server
+                thread, see :attr:`event_queue_statistics`.
+            loop (:class:`asyncio.AbstractEventLoop`): If not ``None`` this
+                value is used as a default for the ``loop`` parameter when
+                calling :meth:`createPV`.
         """
         super().__init__()
         self._encoding = encoding
         self._use_numpy = use_numpy
-        self._server = _Server(self)
-        self._thread = _ServerThread()
+        self._loop = loop
+        self._exist_handler = exist_handler
+        self._attach_handler = attach_handler
+        self._server = _Server(self, search_cache=search_cache, route_cache=route_cache)
+        self._server_ref = weakref.ref(self._server)
+        if publish_rate:
+            self._server.setPublishRate(publish_rate)
+        if event_queue:
+            cas.setEventQueue(event_queue)
 
         self._pvs_lock = threading.Lock()
         self._pvs = weakref.WeakValueDictionary()
         self._encoded_pvs = weakref.WeakValueDictionary()
-        self._aliases = {}
-        self._encoded_aliases = {}
-        self._alias_to_encoded = {}
 
-        self._thread.start()
+        # The native server thread is shared by all servers
+        cas.startThread()
+        self._thread_started = True
 
     def __enter__(self):
         return self
@@ -1033,13 +1305,337 @@ class Server(object):
         """
         Return a dict of all aliases.
 
+        The names are decoded like the name of the PV the alias refers
+        to, with the ``encoding`` parameter of the PV. If no such PV
+        exists the ``encoding`` parameter of the server is used
+        (``utf-8`` if it is ``None``).
+
         This property is thread-safe.
 
         Returns:
             dict(alias: name): Alias mappings
         """
         with self._pvs_lock:
-            return self._aliases.copy()
+            pvs = dict(self._encoded_pvs)
+
+        aliases = {}
+        for alias, name in self._server.aliases().items():
+            pv = pvs.get(name)
+            if pv is None:
+                aliases[self._decode_name(alias)] = self._decode_name(name)
+                continue
+
+            encoding = pv._pv._encoding
+            if encoding is not None:
+                alias = alias.decode(encoding)
+            aliases[alias] = pv.name
+        return aliases
+
+    @property
+    def publish_rate(self):
+        """
+        The number of frames per second in which PV events are published.
+
+        While this is not ``0`` changing the attributes of a PV created
+        with :meth:`createPV` only marks the PV as dirty. Once per frame
+        the server thread publishes all dirty PVs like :meth:`updatePVs`,
+        every PV with a single event for all changes since the last frame.
+        Monitor handlers are called when the frame is published. Read
+        requests always return the current attributes.
+        :meth:`updatePVs` always publishes immediately.
+
+        Setting this to ``0`` disables frames and publishes the
+        dirty PVs immediately.
+
+        This property is thread-safe.
+
+        Returns:
+            float: Frames per second, ``0`` if disabled.
+        """
+        return self._server.publishRate()
+
+    @publish_rate.setter
+    def publish_rate(self, rate):
+        self._server.setPublishRate(rate or 0)
+
+    @property
+    def event_queue_statistics(self):
+        """
+        Return statistics of the event queue.
+
+        With the ``event_queue`` parameter events posted from threads
+        other than the server thread are put into a lock-free queue and
+        posted by the server thread. This avoids contention on the
+        locks of the server when many threads post events. If the queue
+        is full an event is posted directly.
+
+        The queue is shared by all servers of the process.
+
+        This property is thread-safe.
+
+        Returns:
+            dict: A dictionary with the keys ``enabled``, ``capacity``,
+            ``depth`` (number of queued events), ``high_water`` (largest
+            depth so far), ``posted`` (number of events posted from the
+            queue) and ``overflows`` (number of events posted directly
+            because the queue was full).
+        """
+        return cas.eventQueueStatistics()
+
+    @property
+    def search_cache_statistics(self):
+        """
+        Return statistics of the negative search cache.
+
+        This property is thread-safe.
+
+        Returns:
+            dict: A dictionary with the keys ``hits``, ``misses`` and ``size``.
+            See :meth:`cas.Server.searchCacheStatistics`.
+        """
+        return self._server.searchCacheStatistics()
+
+    @property
+    def route_cache_size(self):
+        """
+        int: Number of PVs created by route factories which are currently
+        kept alive.
+
+        This property is thread-safe.
+        """
+        return self._server.routeCacheSize()
+
+    @property
+    def exist_handler(self):
+        """
+        callable: The exist handler.
+
+        This is writeable and changes the exist handler. Set it to
+        ``None`` to disable the handler.
+        """
+        return self._exist_handler
+
+    @exist_handler.setter
+    def exist_handler(self, handler):
+        self._exist_handler = handler
+        self.clearSearchCache()
+
+    @property
+    def attach_handler(self):
+        """
+        callable: The attach handler.
+
+        This is writeable and changes the attach handler. Set it to
+        ``None`` to disable the handler.
+        """
+        return self._attach_handler
+
+    @attach_handler.setter
+    def attach_handler(self, handler):
+        self._attach_handler = handler
+
+    def clearSearchCache(self):
+        """
+        Clear the negative search cache.
+
+        This method is thread-safe.
+        """
+        self._server.clearSearchCache()
+
+    def updatePVs(self, updates):
+        """
+        Update the attributes of many PVs and post all events at once.
+
+        This is faster than updating every PV separately because the
+        events of all PVs are posted together. Monitor handlers are
+        called after all events are posted.
+
+        This method is thread-safe.
+
+        Args:
+            updates: Iterable of ``(pv, attributes)`` tuples. ``pv`` is a
+                :class:`PV` object and ``attributes`` an attributes
+                dictionary with the attributes to change.
+        """
+        publishes = []
+        for pv, attributes in updates:
+            with pv._attributes_lock:
+                pv._update_attributes(attributes)
+                publishes.append((pv, pv._monitor_handler, pv._prepare_publish()))
+        self._post_publishes(publishes)
+
+    def _publish_frame(self, pvs):
+        """ Publish the PVs marked dirty during the last frame. """
+        publishes = []
+        for pv in pvs:
+            with pv._attributes_lock:
+                # The store was updated when the PV was marked dirty
+                publishes.append((pv, pv._monitor_handler, pv._prepare_publish(update_store=False)))
+        self._post_publishes(publishes)
+
+    def _post_publishes(self, publishes):
+        """
+        Post the events of many PVs at once and call the monitor handlers.
+
+        ``publishes`` is a list of ``(pv, monitor_handler, publish)``
+        tuples with the results of :meth:`PV._prepare_publish`.
+        """
+        entries = []
+        notifications = []
+        for pv, monitor_handler, publish in publishes:
+            if publish is None:
+                continue
+
+            events, attributes, encoded_attributes = publish
+            if encoded_attributes is not None:
+                entries.append((pv._pv, events, encoded_attributes))
+            if monitor_handler:
+                notifications.append((monitor_handler, pv, attributes))
+
+        self._server.postEvents(entries)
+        for monitor_handler, pv, attributes in notifications:
+            monitor_handler(pv, attributes)
+
+    def addRoute(self, pattern, factory):
+        """
+        Create PVs matching a name pattern on demand.
+
+        This allows serving large parametric namespaces without creating
+        all PVs up front. ``pattern`` is a glob pattern, ``*`` matches
+        any sequence of characters and ``?`` matches a single character,
+        e.g. ``DEV:*:CH??:VALUE``.
+
+        Searches for matching names are answered positively. When a client
+        connects to a matching name for which no PV exists the factory is
+        called. The returned PVs are kept alive by the server. If more than
+        ``route_cache`` PVs are kept alive, the least recently used ones
+        without connected clients are released.
+
+        Routes are checked in the order they are added, after the PVs
+        created with :meth:`createPV` and before the exist and attach
+        handlers.
+
+        This method is thread-safe.
+
+            **Signature**: ``factory(server, name)``
+
+            **Parameters**:
+
+                * **server** (:class:`Server`): This server.
+                * **name** (str): The requested name.
+
+            **Returns**:
+                * A :class:`PV` object, typically created with :meth:`createPV`.
+                * ``None`` if the PV does not exist.
+
+        Args:
+            pattern (str): The name pattern.
+            factory (callable): The PV factory.
+        """
+        def create(pv_name):
+            pv = factory(self, self._decode_name(pv_name))
+            if pv is None:
+                return None
+            return pv._pv
+
+        self._server.addRoute(self._encode_name(pattern), create)
+
+    def removeRoute(self, pattern):
+        """
+        Remove a route added with :meth:`addRoute`.
+
+        Already created PVs are kept until they are released.
+
+        This method is thread-safe.
+
+        Args:
+            pattern (str): The name pattern.
+        """
+        if not self._server.removeRoute(self._encode_name(pattern)):
+            raise KeyError(pattern)
+
+    def addShard(self, address, weight=1):
+        """
+        Redirect searches to a backend server.
+
+        This allows one server to act as a front-end for several backend
+        server processes. Searches for names which are not served by this
+        server, i.e. are not registered, match no route and are not
+        accepted by the exist handler, are answered by redirecting the
+        client to a backend server.
+        The names are distributed over the backend servers with consistent
+        hashing, so adding or removing a server only moves the names of
+        that server. All backend servers must therefore agree on the
+        same shard list to know which PVs they have to serve,
+        see :meth:`shardFor`.
+
+        This method is thread-safe.
+
+        Args:
+            address (tuple): A tuple ``(ip, port)`` of the backend server.
+                The IP address can be a string or a 32bit integer.
+            weight (int): Relative share of names handled by this server.
+        """
+        self._server.addShard(_to_address(address), weight)
+
+    def removeShard(self, address):
+        """
+        Remove a backend server added with :meth:`addShard`.
+
+        This method is thread-safe.
+
+        Args:
+            address (tuple): A tuple ``(ip, port)`` of the backend server.
+        """
+        if not self._server.removeShard(_to_address(address)):
+            raise KeyError(address)
+
+    def addShardPrefix(self, prefix, address):
+        """
+        Redirect searches for all names starting with ``prefix`` to a
+        backend server.
+
+        Prefix rules take precedence over the shards added
+        with :meth:`addShard`. The longest matching prefix wins.
+
+        This method is thread-safe.
+
+        Args:
+            prefix (str): The name prefix.
+            address (tuple): A tuple ``(ip, port)`` of the backend server.
+        """
+        self._server.addShardPrefix(self._encode_name(prefix), _to_address(address))
+
+    def removeShardPrefix(self, prefix):
+        """
+        Remove a prefix rule added with :meth:`addShardPrefix`.
+
+        This method is thread-safe.
+
+        Args:
+            prefix (str): The name prefix.
+        """
+        if not self._server.removeShardPrefix(self._encode_name(prefix)):
+            raise KeyError(prefix)
+
+    def shardFor(self, name):
+        """
+        Return the backend server which serves ``name``.
+
+        This method is thread-safe.
+
+        Args:
+            name (str): A PV name.
+
+        Returns:
+            tuple: A tuple ``(ip, port)`` with the IP address as a string
+            or ``None`` if no backend server is configured.
+        """
+        address = self._server.shardFor(self._encode_name(name))
+        if address is None:
+            return None
+        host, port = address
+        return (socket.inet_ntoa(struct.pack('!I', host)), port)
 
     def shutdown(self):
         """
@@ -1047,8 +1643,9 @@ class Server(object):
 
         After this is called no other methods can be called.
         """
-        self._thread.stop()
-        self._thread.join()
+        if self._thread_started:
+            self._thread_started = False
+            cas.stopThread()
         self._server = None
 
     def createPV(self, *args, **kwargs):
@@ -1074,11 +1671,15 @@ class Server(object):
             kwargs['encoding'] = self._encoding
         if 'use_numpy' not in kwargs and self._use_numpy is not None:
             kwargs['use_numpy'] = self._use_numpy
+        if 'loop' not in kwargs and self._loop is not None:
+            kwargs['loop'] = self._loop
 
         pv = PV(*args, **kwargs)
+        pv._frame_publisher = self._server_ref
         with self._pvs_lock:
             self._pvs[pv.name] = pv
             self._encoded_pvs[pv._pv.name()] = pv
+            self._server.registerPV(pv._pv)
         return pv
 
     def retreivePV(self, name):
@@ -1097,10 +1698,12 @@ class Server(object):
         """
         with self._pvs_lock:
             pv = self._pvs.get(name)
-            if pv is None:
-                name = self._aliases.get(name)
-                if name is not None:
-                    pv = self._pvs.get(name)
+
+        if pv is None:
+            encoded_name = self._server.resolveAlias(self._encode_name(name))
+            if encoded_name is not None:
+                with self._pvs_lock:
+                    pv = self._encoded_pvs.get(encoded_name)
 
         if pv is None:
             raise KeyError
@@ -1114,6 +1717,8 @@ class Server(object):
         the alias list ist checked. If an alias exists a second search
         using the original name is made and if a PV exists it is used.
 
+        Aliases are resolved by the server without calling into Python.
+
         This method is thread-safe.
 
         Args:
@@ -1122,80 +1727,121 @@ class Server(object):
             encoding (str): The encoding used for the names.
                             See *encoding* parameter of :class:`PV` objects.
         """
-        if encoding is _sentinal:
-            if self._encoding is None:
-                encoding = 'utf-8'
-            else:
-                encoding = self._encoding
+        encoding = self._alias_encoding(encoding)
+        if encoding is not None:
+            alias = alias.encode(encoding)
+            name = name.encode(encoding)
 
+        self._server.addAlias(alias, name)
+
+    def addAliases(self, aliases, *, encoding=_sentinal):
+        """
+        Add many aliases at once.
+
+        This is much faster than calling :meth:`addAlias` for each alias.
+
+        This method is thread-safe.
+
+        Args:
+            aliases: A dictionary mapping aliases to the original names or
+                an iterable of ``(alias, name)`` tuples.
+            encoding (str): The encoding used for the names.
+                            See *encoding* parameter of :class:`PV` objects.
+        """
+        encoding = self._alias_encoding(encoding)
+        if isinstance(aliases, dict):
+            aliases = aliases.items()
         if encoding is not None:
-            encoded_alias = alias.encode(encoding)
-            encoded_name = name.encode(encoding)
-        else:
-            encoded_alias = alias
-            encoded_name = name
+            aliases = [ (alias.encode(encoding), name.encode(encoding)) for alias, name in aliases ]
 
-        with self._pvs_lock:
-            self._aliases[alias] = name
-            self._encoded_aliases[encoded_alias] = encoded_name
-            self._alias_to_encoded[alias] = encoded_alias
+        self._server.addAliases(aliases)
+
+    def loadAliases(self, path):
+        """
+        Add aliases from a file.
+
+        Each line contains an alias and the original name separated by
+        whitespace. Empty lines and lines starting with ``#`` are ignored.
+        The file is read by the server without decoding the names, they
+        must use the same encoding as the PVs. Nothing is added if the file
+        contains an invalid line.
+
+        This method is thread-safe.
+
+        Args:
+            path (str): Path of the alias file.
 
-    def removeAlias(self, alias):
+        Returns:
+            int: The number of aliases read.
+        """
+        return self._server.loadAliases(path)
+
+    def removeAlias(self, alias, *, encoding=_sentinal):
         """
         Remove an alias.
 
         Args:
             alias (str): The alias to remove
+            encoding (str): The encoding used for the alias.
+                            See *encoding* parameter of :class:`PV` objects.
         """
-        with self._pvs_lock:
-            del self._aliases[alias]
-            encoded_alias = self._alias_to_encoded.get(alias)
-            del self._alias_to_encoded[alias]
-            del self._encoded_aliases[encoded_alias]
+        encoding = self._alias_encoding(encoding)
+        encoded_alias = alias.encode(encoding) if encoding is not None else alias
+        if not self._server.removeAlias(encoded_alias):
+            raise KeyError(alias)
 
-    def _get_pv(self, pv_name):
-        with self._pvs_lock:
-            pv = self._encoded_pvs.get(pv_name)
-            if pv is None:
-                pv_name = self._encoded_aliases.get(pv_name)
-                if pv_name is not None:
-                    pv = self._encoded_pvs.get(pv_name)
-        return pv
+    def _alias_encoding(self, encoding):
+        if encoding is _sentinal:
+            if self._encoding is None:
+                return 'utf-8'
+            return self._encoding
+        return encoding
+
+    def _encode_name(self, pv_name):
+        encoding = self._encoding
+        if encoding is None:
+            encoding = 'utf-8'
+        return pv_name.encode(encoding)
+
+    def _decode_name(self, pv_name):
+        encoding = self._encoding
+        if encoding is None:
+            encoding = 'utf-8'
+        return pv_name.decode(encoding)
 
 
 class _Server(cas.Server):
     """
     cas.Server implementation.
     """
-    def __init__(self, server):
-        super().__init__()
+    def __init__(self, server, **kwargs):
+        super().__init__(**kwargs)
         self._server = server
 
-    def pvExistTest(self, client, pv_name):
-        if self._server._get_pv(pv_name) is not None:
-            return ExistsResponse.EXISTS_HERE
+    def pvExistTest(self, client, pv_name, context):
+        server = self._server
+        handler = server._exist_handler
+        if handler:
+            result = handler(server, server._decode_name(pv_name), context)
+            return _to_exists_response(result)
 
         return ExistsResponse.NOT_EXISTS_HERE
 
-    def pvAttach(self, pv_name):
-        pv = self._server._get_pv(pv_name)
-        if pv is not None:
-            return pv._pv
+    def pvAttach(self, pv_name, context):
+        server = self._server
+        handler = server._attach_handler
+        if handler:
+            result = handler(server, server._decode_name(pv_name), context)
+            if isinstance(result, AsyncPVAttach):
+                return result
+            if result is not None:
+                return result._pv
 
         return AttachResponse.NOT_FOUND
 
+    def publishFrame(self, pvs):
+        self._server._publish_frame(pvs)
 
-class _ServerThread(threading.Thread):
-    """
-    A thread calling cas.process() until :meth:`stop()` is called.
-    """
-    def __init__(self):
-        super().__init__()
-        self._should_stop = threading.Event()
-
-    def run(self):
-        while not self._should_stop.is_set():
-            cas.process(0.1)
 
-    def stop(self):
-        self._should_stop.set()
+# The native server thread must not call into python during finalization
+atexit.register(cas.stopThread, force=True)
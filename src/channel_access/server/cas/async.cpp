@@ -385,7 +385,8 @@ PyDoc_STRVAR(read_complete__doc__, R"(complete(attributes)
 Signal the successful completion of the asynchronous read.
 
 Args:
-    attributes (dict): An attributes dictionary with the requested values.
+    attributes (dict|Attributes): An attributes dictionary or :class:`Attributes`
+        object with the requested values.
 )");
 PyDoc_STRVAR(read_fail__doc__, R"(fail()
 Signal a failure in completing the asynchronous read.
@@ -451,6 +452,389 @@ PyTypeObject async_read_type = {
     async_read_new,                            /* tp_new */
 };
 
+
+
+
+class AsyncPVExistProxy;
+struct AsyncPVExist {
+    PyObject_HEAD
+    bool held_by_server;
+    std::unique_ptr<AsyncPVExistProxy> proxy;
+};
+static_assert(std::is_standard_layout<AsyncPVExist>::value, "AsyncPVExist has to be standard layout to work with the Python API");
+
+class AsyncPVExistProxy : public casAsyncPVExistIO {
+public:
+    AsyncPVExistProxy(PyObject* async_exist_, casCtx const& ctx)
+        : casAsyncPVExistIO{ctx}, async_exist{async_exist_}
+    {
+        // No GIL, don't use the python API
+    }
+
+    PyObject* post(pvExistReturn const& ret)
+    {
+        caStatus result = postIOCompletion(ret);
+        switch (result) {
+            case S_cas_success :
+            case S_cas_redundantPost :
+                break;
+            default:
+                PyErr_SetString(PyExc_RuntimeError, "Could not post exist test IO completion");
+                return nullptr;
+        }
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* complete(PyObject* self, PyObject* args)
+    {
+        AsyncPVExist* async = reinterpret_cast<AsyncPVExist*>(self);
+        AsyncPVExistProxy* proxy = async->proxy.get();
+
+        PyObject* response = nullptr;
+        if (not PyArg_ParseTuple(args, "O", &response)) {
+            proxy->post(pverDoesNotExistHere);
+            return nullptr;
+        }
+
+        pvExistReturn ret = pverDoesNotExistHere;
+        if (not to_exist_return(response, ret)) {
+            proxy->post(pverDoesNotExistHere);
+            return nullptr;
+        }
+
+        return proxy->post(ret);
+    }
+
+    static PyObject* fail(PyObject* self, PyObject*)
+    {
+        AsyncPVExist* async = reinterpret_cast<AsyncPVExist*>(self);
+        AsyncPVExistProxy* proxy = async->proxy.get();
+
+        return proxy->post(pverDoesNotExistHere);
+    }
+
+private:
+    PyObject* async_exist;
+
+    virtual void destroy() override
+    {
+        AsyncPVExist* async = reinterpret_cast<AsyncPVExist*>(async_exist);
+
+        PyGILState_STATE gstate = PyGILState_Ensure();
+            // the caServer released its ownership so we have to decrement the python reference count
+            if (async->held_by_server) {
+                async->held_by_server = false;
+                Py_DECREF(async_exist);
+            }
+        PyGILState_Release(gstate);
+    }
+};
+
+
+int async_exist_init(PyObject* self, PyObject* args, PyObject*)
+{
+    AsyncPVExist* async_exist = reinterpret_cast<AsyncPVExist*>(self);
+
+    PyObject* context = nullptr;
+    if (not PyArg_ParseTuple(args, "O", &context)) return -1;
+
+    auto* context_type = reinterpret_cast<PyObject*>(&async_context_type);
+    switch (PyObject_IsInstance(context, context_type)) {
+        case 1:
+            break;
+        case 0:
+            PyErr_SetString(PyExc_TypeError, "context argument must be a context object");
+        default:
+            return -1;
+    }
+
+    AsyncContext* async_context = reinterpret_cast<AsyncContext*>(context);
+
+    async_exist->held_by_server = false;
+    Py_BEGIN_ALLOW_THREADS
+        async_exist->proxy.reset(new AsyncPVExistProxy(self, *async_context->ctx));
+    Py_END_ALLOW_THREADS
+
+    return 0;
+}
+
+void async_exist_dealloc(PyObject* self)
+{
+    AsyncPVExist* async_exist = reinterpret_cast<AsyncPVExist*>(self);
+
+    async_exist->proxy.reset();
+
+    Py_TYPE(self)->tp_free(self);
+}
+
+PyObject* async_exist_new(PyTypeObject* type, PyObject* args, PyObject* kwds)
+{
+    PyObject* self = type->tp_alloc(type, 0);
+    if (not self) return nullptr;
+
+    return self;
+}
+
+PyDoc_STRVAR(exist_complete__doc__, R"(complete(response)
+Signal the completion of the asynchronous exist test.
+
+Args:
+    response: An :class:`ExistsResponse` value or a tuple ``(ip, port)``
+        like the return value of :meth:`Server.pvExistTest()`.
+)");
+PyDoc_STRVAR(exist_fail__doc__, R"(fail()
+Signal a failure in completing the asynchronous exist test.
+
+The PV is reported as not existing on this server.
+)");
+PyMethodDef async_exist_methods[] = {
+    {"complete", static_cast<PyCFunction>(AsyncPVExistProxy::complete), METH_VARARGS, exist_complete__doc__},
+    {"fail",     static_cast<PyCFunction>(AsyncPVExistProxy::fail),     METH_NOARGS,  exist_fail__doc__},
+    {nullptr}
+};
+
+PyDoc_STRVAR(async_exist__doc__, R"(AsyncPVExist(context)
+Asynchronous exist test completion class.
+
+Return an object of this class from the :meth:`Server.pvExistTest()` to
+signal an asynchronous exist test. Then call :meth:`complete()` or
+:meth:`fail()` to inform the server about the result.
+
+Args:
+    context: Context object given to the :meth:`Server.pvExistTest()` method.
+)");
+PyTypeObject async_exist_type = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "ca_server.cas.AsyncPVExist",              /* tp_name */
+    sizeof(AsyncPVExist),                      /* tp_basicsize */
+    0,                                         /* tp_itemsize */
+    async_exist_dealloc,                       /* tp_dealloc */
+    0,                                         /* tp_vectorcall_offset */
+    nullptr,                                   /* tp_getattr */
+    nullptr,                                   /* tp_setattr */
+    nullptr,                                   /* tp_as_async */
+    nullptr,                                   /* tp_repr */
+    nullptr,                                   /* tp_as_number */
+    nullptr,                                   /* tp_as_sequence */
+    nullptr,                                   /* tp_as_mapping */
+    nullptr,                                   /* tp_hash */
+    nullptr,                                   /* tp_call */
+    nullptr,                                   /* tp_str */
+    nullptr,                                   /* tp_getattro */
+    nullptr,                                   /* tp_setattro */
+    nullptr,                                   /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,  /* tp_flags */
+    async_exist__doc__,                        /* tp_doc */
+    nullptr,                                   /* tp_traverse */
+    nullptr,                                   /* tp_clear */
+    nullptr,                                   /* tp_richcompare */
+    0,                                         /* tp_weaklistoffset */
+    nullptr,                                   /* tp_iter */
+    nullptr,                                   /* tp_iternext */
+    async_exist_methods,                       /* tp_methods */
+    nullptr,                                   /* tp_members */
+    nullptr,                                   /* tp_getset */
+    nullptr,                                   /* tp_base */
+    nullptr,                                   /* tp_dict */
+    nullptr,                                   /* tp_descr_get */
+    nullptr,                                   /* tp_descr_set */
+    0,                                         /* tp_dictoffset */
+    async_exist_init,                          /* tp_init */
+    nullptr,                                   /* tp_alloc */
+    async_exist_new,                           /* tp_new */
+};
+
+
+
+class AsyncPVAttachProxy;
+struct AsyncPVAttach {
+    PyObject_HEAD
+    bool held_by_server;
+    std::unique_ptr<AsyncPVAttachProxy> proxy;
+};
+static_assert(std::is_standard_layout<AsyncPVAttach>::value, "AsyncPVAttach has to be standard layout to work with the Python API");
+
+class AsyncPVAttachProxy : public casAsyncPVAttachIO {
+public:
+    AsyncPVAttachProxy(PyObject* async_attach_, casCtx const& ctx)
+        : casAsyncPVAttachIO{ctx}, async_attach{async_attach_}
+    {
+        // No GIL, don't use the python API
+    }
+
+    PyObject* post(pvAttachReturn const& ret)
+    {
+        caStatus result = postIOCompletion(ret);
+        switch (result) {
+            case S_cas_success :
+            case S_cas_redundantPost :
+                break;
+            default:
+                PyErr_SetString(PyExc_RuntimeError, "Could not post attach IO completion");
+                return nullptr;
+        }
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* complete(PyObject* self, PyObject* args)
+    {
+        AsyncPVAttach* async = reinterpret_cast<AsyncPVAttach*>(self);
+        AsyncPVAttachProxy* proxy = async->proxy.get();
+
+        PyObject* response = nullptr;
+        if (not PyArg_ParseTuple(args, "O", &response)) {
+            proxy->post(S_casApp_pvNotFound);
+            return nullptr;
+        }
+
+        pvAttachReturn ret = S_casApp_pvNotFound;
+        if (not to_attach_return(response, ret)) {
+            proxy->post(S_casApp_pvNotFound);
+            return nullptr;
+        }
+
+        return proxy->post(ret);
+    }
+
+    static PyObject* fail(PyObject* self, PyObject*)
+    {
+        AsyncPVAttach* async = reinterpret_cast<AsyncPVAttach*>(self);
+        AsyncPVAttachProxy* proxy = async->proxy.get();
+
+        return proxy->post(S_casApp_pvNotFound);
+    }
+
+private:
+    PyObject* async_attach;
+
+    virtual void destroy() override
+    {
+        AsyncPVAttach* async = reinterpret_cast<AsyncPVAttach*>(async_attach);
+
+        PyGILState_STATE gstate = PyGILState_Ensure();
+            // the caServer released its ownership so we have to decrement the python reference count
+            if (async->held_by_server) {
+                async->held_by_server = false;
+                Py_DECREF(async_attach);
+            }
+        PyGILState_Release(gstate);
+    }
+};
+
+
+int async_attach_init(PyObject* self, PyObject* args, PyObject*)
+{
+    AsyncPVAttach* async_attach = reinterpret_cast<AsyncPVAttach*>(self);
+
+    PyObject* context = nullptr;
+    if (not PyArg_ParseTuple(args, "O", &context)) return -1;
+
+    auto* context_type = reinterpret_cast<PyObject*>(&async_context_type);
+    switch (PyObject_IsInstance(context, context_type)) {
+        case 1:
+            break;
+        case 0:
+            PyErr_SetString(PyExc_TypeError, "context argument must be a context object");
+        default:
+            return -1;
+    }
+
+    AsyncContext* async_context = reinterpret_cast<AsyncContext*>(context);
+
+    async_attach->held_by_server = false;
+    Py_BEGIN_ALLOW_THREADS
+        async_attach->proxy.reset(new AsyncPVAttachProxy(self, *async_context->ctx));
+    Py_END_ALLOW_THREADS
+
+    return 0;
+}
+
+void async_attach_dealloc(PyObject* self)
+{
+    AsyncPVAttach* async_attach = reinterpret_cast<AsyncPVAttach*>(self);
+
+    async_attach->proxy.reset();
+
+    Py_TYPE(self)->tp_free(self);
+}
+
+PyObject* async_attach_new(PyTypeObject* type, PyObject* args, PyObject* kwds)
+{
+    PyObject* self = type->tp_alloc(type, 0);
+    if (not self) return nullptr;
+
+    return self;
+}
+
+PyDoc_STRVAR(attach_complete__doc__, R"(complete(response)
+Signal the completion of the asynchronous attach.
+
+Args:
+    response: A :class:`PV` instance or an :class:`AttachResponse` value
+        like the return value of :meth:`Server.pvAttach()`.
+)");
+PyDoc_STRVAR(attach_fail__doc__, R"(fail()
+Signal a failure in completing the asynchronous attach.
+
+The PV is reported as not found.
+)");
+PyMethodDef async_attach_methods[] = {
+    {"complete", static_cast<PyCFunction>(AsyncPVAttachProxy::complete), METH_VARARGS, attach_complete__doc__},
+    {"fail",     static_cast<PyCFunction>(AsyncPVAttachProxy::fail),     METH_NOARGS,  attach_fail__doc__},
+    {nullptr}
+};
+
+PyDoc_STRVAR(async_attach__doc__, R"(AsyncPVAttach(context)
+Asynchronous attach completion class.
+
+Return an object of this class from the :meth:`Server.pvAttach()` to
+signal an asynchronous attach. Then call :meth:`complete()` or
+:meth:`fail()` to inform the server about the result.
+
+Args:
+    context: Context object given to the :meth:`Server.pvAttach()` method.
+)");
+PyTypeObject async_attach_type = {
+    PyVarObject_HEAD_INIT(nullptr, 0)
+    "ca_server.cas.AsyncPVAttach",             /* tp_name */
+    sizeof(AsyncPVAttach),                     /* tp_basicsize */
+    0,                                         /* tp_itemsize */
+    async_attach_dealloc,                      /* tp_dealloc */
+    0,                                         /* tp_vectorcall_offset */
+    nullptr,                                   /* tp_getattr */
+    nullptr,                                   /* tp_setattr */
+    nullptr,                                   /* tp_as_async */
+    nullptr,                                   /* tp_repr */
+    nullptr,                                   /* tp_as_number */
+    nullptr,                                   /* tp_as_sequence */
+    nullptr,                                   /* tp_as_mapping */
+    nullptr,                                   /* tp_hash */
+    nullptr,                                   /* tp_call */
+    nullptr,                                   /* tp_str */
+    nullptr,                                   /* tp_getattro */
+    nullptr,                                   /* tp_setattro */
+    nullptr,                                   /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,  /* tp_flags */
+    async_attach__doc__,                       /* tp_doc */
+    nullptr,                                   /* tp_traverse */
+    nullptr,                                   /* tp_clear */
+    nullptr,                                   /* tp_richcompare */
+    0,                                         /* tp_weaklistoffset */
+    nullptr,                                   /* tp_iter */
+    nullptr,                                   /* tp_iternext */
+    async_attach_methods,                      /* tp_methods */
+    nullptr,                                   /* tp_members */
+    nullptr,                                   /* tp_getset */
+    nullptr,                                   /* tp_base */
+    nullptr,                                   /* tp_dict */
+    nullptr,                                   /* tp_descr_get */
+    nullptr,                                   /* tp_descr_set */
+    0,                                         /* tp_dictoffset */
+    async_attach_init,                         /* tp_init */
+    nullptr,                                   /* tp_alloc */
+    async_attach_new,                          /* tp_new */
+};
+
 }
 
 
@@ -496,6 +880,34 @@ void destroy_async_read_type()
 }
 
 
+PyObject* create_async_exist_type()
+{
+    if (PyType_Ready(&async_exist_type) < 0) return nullptr;
+
+    Py_INCREF(&async_exist_type);
+    return reinterpret_cast<PyObject*>(&async_exist_type);
+}
+
+void destroy_async_exist_type()
+{
+    Py_DECREF(&async_exist_type);
+}
+
+
+PyObject* create_async_attach_type()
+{
+    if (PyType_Ready(&async_attach_type) < 0) return nullptr;
+
+    Py_INCREF(&async_attach_type);
+    return reinterpret_cast<PyObject*>(&async_attach_type);
+}
+
+void destroy_async_attach_type()
+{
+    Py_DECREF(&async_attach_type);
+}
+
+
 PyObject* create_async_context(casCtx const& ctx, gdd* prototype, aitEnum type)
 {
     AsyncContext* context = PyObject_New(AsyncContext, &async_context_type);
@@ -531,4 +943,28 @@ bool give_async_write_to_server(PyObject* obj)
     return true;
 }
 
+bool give_async_exist_to_server(PyObject* obj)
+{
+    auto* exist_type = reinterpret_cast<PyObject*>(&async_exist_type);
+    if (PyObject_IsInstance(obj, exist_type) != 1) return false;
+
+    AsyncPVExist* async = reinterpret_cast<AsyncPVExist*>(obj);
+    async->held_by_server = true;
+    Py_INCREF(obj); // caServer now holds a reference
+
+    return true;
+}
+
+bool give_async_attach_to_server(PyObject* obj)
+{
+    auto* attach_type = reinterpret_cast<PyObject*>(&async_attach_type);
+    if (PyObject_IsInstance(obj, attach_type) != 1) return false;
+
+    AsyncPVAttach* async = reinterpret_cast<AsyncPVAttach*>(obj);
+    async->held_by_server = true;
+    Py_INCREF(obj); // caServer now holds a reference
+
+    return true;
+}
+
 }
@@ -36,6 +36,26 @@ PyObject* create_async_write_type();
 void destroy_async_write_type();
 
 
+/** Create the AsyncPVExist type.
+ * Returns new reference.
+ */
+PyObject* create_async_exist_type();
+
+/** Destroy the AsyncPVExist type.
+ */
+void destroy_async_exist_type();
+
+
+/** Create the AsyncPVAttach type.
+ * Returns new reference.
+ */
+PyObject* create_async_attach_type();
+
+/** Destroy the AsyncPVAttach type.
+ */
+void destroy_async_attach_type();
+
+
 /** Create an asnyc context object.
  * Returns new reference.
  */
@@ -55,6 +75,20 @@ bool give_async_read_to_server(PyObject* obj);
  */
 bool give_async_write_to_server(PyObject* obj);
 
+/** Try to give an async exist test handler object to the server.
+ *
+ * Returns:
+ *  ``True`` if the object is an async exist test object and is given to the server.
+ */
+bool give_async_exist_to_server(PyObject* obj);
+
+/** Try to give an async attach handler object to the server.
+ *
+ * Returns:
+ *  ``True`` if the object is an async attach object and is given to the server.
+ */
+bool give_async_attach_to_server(PyObject* obj);
+
 }
 
 #endif
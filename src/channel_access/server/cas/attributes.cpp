@@ -0,0 +1,411 @@
+#include "attributes.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <Python.h>
+#include <datetime.h>
+#include <epicsTime.h>
+
+namespace cas {
+namespace {
+
+char const* const limits_names[] = {
+    "display_limits",
+    "warning_limits",
+    "alarm_limits",
+    "control_limits"
+};
+
+// Days since 1970-01-01 in the proleptic gregorian calendar
+long long days_from_civil(long long year, unsigned month, unsigned day)
+{
+    year -= month <= 2;
+    long long const era = (year >= 0 ? year : year - 399) / 400;
+    unsigned const year_of_era = static_cast<unsigned>(year - era * 400);
+    unsigned const day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    unsigned const day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + static_cast<long long>(day_of_era) - 719468;
+}
+
+bool posix_to_timestamp(long long seconds, long nsec, epicsTimeStamp& timestamp)
+{
+    if (seconds < POSIX_TIME_AT_EPICS_EPOCH or seconds - POSIX_TIME_AT_EPICS_EPOCH > 0xffffffffll) {
+        PyErr_SetString(PyExc_ValueError, "Timestamp out of range of epics timestamps");
+        return false;
+    }
+
+    timestamp.secPastEpoch = static_cast<epicsUInt32>(seconds - POSIX_TIME_AT_EPICS_EPOCH);
+    timestamp.nsec = static_cast<epicsUInt32>(nsec);
+    return true;
+}
+
+// Naive datetimes are treated as UTC
+bool datetime_to_timestamp(PyObject* obj, epicsTimeStamp& timestamp)
+{
+    long long seconds = days_from_civil(PyDateTime_GET_YEAR(obj), PyDateTime_GET_MONTH(obj), PyDateTime_GET_DAY(obj)) * 86400
+        + PyDateTime_DATE_GET_HOUR(obj) * 3600
+        + PyDateTime_DATE_GET_MINUTE(obj) * 60
+        + PyDateTime_DATE_GET_SECOND(obj);
+    long usec = PyDateTime_DATE_GET_MICROSECOND(obj);
+
+    if (reinterpret_cast<PyDateTime_DateTime*>(obj)->hastzinfo) {
+        PyObject* offset = PyObject_CallMethod(obj, "utcoffset", nullptr);
+        if (not offset) return false;
+
+        if (PyDelta_Check(offset)) {
+            seconds -= PyDateTime_DELTA_GET_DAYS(offset) * 86400ll + PyDateTime_DELTA_GET_SECONDS(offset);
+            usec -= PyDateTime_DELTA_GET_MICROSECONDS(offset);
+            if (usec < 0) {
+                usec += 1000000;
+                seconds -= 1;
+            }
+        }
+        Py_DECREF(offset);
+    }
+
+    return posix_to_timestamp(seconds, usec * 1000, timestamp);
+}
+
+bool to_unit(PyObject* obj, Attributes& attributes)
+{
+    char* str;
+    Py_ssize_t size;
+    if (PyBytes_AsStringAndSize(obj, &str, &size) != 0) return false;
+
+    if (size > MAX_STRING_SIZE-1) {
+        PyErr_Format(PyExc_ValueError, "String length exceeds maximum epics string size of %i bytes", MAX_STRING_SIZE-1);
+        return false;
+    }
+
+    std::memcpy(attributes.unit, str, size);
+    attributes.unit[size] = '\0';
+    attributes.unit_length = size;
+    return true;
+}
+
+bool to_limits(PyObject* obj, LimitsKind kind, Attributes& attributes)
+{
+    double* limits = attributes.limits[static_cast<unsigned>(kind)];
+
+    if (not PyTuple_Check(obj) or PyTuple_Size(obj) != 2) {
+        PyErr_Format(PyExc_TypeError, "%s must be a (lower, upper) tuple", limits_name(kind));
+        return false;
+    }
+
+    limits[0] = PyFloat_AsDouble(PyTuple_GET_ITEM(obj, 0));
+    if (PyErr_Occurred()) return false;
+
+    limits[1] = PyFloat_AsDouble(PyTuple_GET_ITEM(obj, 1));
+    if (PyErr_Occurred()) return false;
+
+    return true;
+}
+
+
+PyObject* attributes_new(PyTypeObject* type, PyObject* args, PyObject* kwds)
+{
+    static char const* keywords[] = {
+        "value", "status", "severity", "timestamp", "precision", "unit", "enum_strings",
+        "display_limits", "warning_limits", "alarm_limits", "control_limits", nullptr
+    };
+    PyObject* value = nullptr, *status = nullptr, *severity = nullptr, *timestamp = Py_None;
+    PyObject* precision = nullptr, *unit = nullptr, *enum_strings = nullptr;
+    PyObject* limits[4] = { nullptr, nullptr, nullptr, nullptr };
+    if (not PyArg_ParseTupleAndKeywords(args, kwds, "|$OOOOOOOOOOO:Attributes", const_cast<char**>(keywords),
+            &value, &status, &severity, &timestamp, &precision, &unit, &enum_strings,
+            &limits[0], &limits[1], &limits[2], &limits[3])) {
+        return nullptr;
+    }
+
+    PyObject* self = type->tp_alloc(type, 0);
+    if (not self) return nullptr;
+
+    Attributes* attributes = reinterpret_cast<Attributes*>(self);
+    attributes->fields = 0;
+    attributes->value = nullptr;
+    attributes->status = 0;
+    attributes->severity = 0;
+    attributes->precision = 0;
+    attributes->unit[0] = '\0';
+    attributes->unit_length = 0;
+    attributes->enum_strings = nullptr;
+
+    if (value) {
+        Py_INCREF(value);
+        attributes->value = value;
+        attributes->fields |= Attributes::field_value;
+    }
+
+    if (status and not enum_to_int(status, attributes->status)) goto error;
+    if (severity and not enum_to_int(severity, attributes->severity)) goto error;
+    if (not to_epics_timestamp(timestamp, attributes->timestamp)) goto error;
+
+    if (precision) {
+        attributes->precision = PyLong_AsLong(precision);
+        if (PyErr_Occurred()) goto error;
+        attributes->fields |= Attributes::field_precision;
+    }
+
+    if (unit) {
+        if (not to_unit(unit, *attributes)) goto error;
+        attributes->fields |= Attributes::field_unit;
+    }
+
+    if (enum_strings) {
+        if (not PyTuple_Check(enum_strings)) {
+            PyErr_SetString(PyExc_TypeError, "enum_strings must be a tuple");
+            goto error;
+        }
+        Py_INCREF(enum_strings);
+        attributes->enum_strings = enum_strings;
+        attributes->fields |= Attributes::field_enum_strings;
+    }
+
+    for (unsigned i = 0; i < 4; ++i) {
+        if (limits[i]) {
+            if (not to_limits(limits[i], static_cast<LimitsKind>(i), *attributes)) goto error;
+            attributes->fields |= Attributes::field_limits << i;
+        }
+    }
+
+    return self;
+
+error:
+    Py_DECREF(self);
+    return nullptr;
+}
+
+void attributes_dealloc(PyObject* self)
+{
+    Attributes* attributes = reinterpret_cast<Attributes*>(self);
+
+    Py_XDECREF(attributes->value);
+    Py_XDECREF(attributes->enum_strings);
+
+    Py_TYPE(self)->tp_free(self);
+}
+
+
+PyObject* get_value(PyObject* self, void*)
+{
+    Attributes* attributes = reinterpret_cast<Attributes*>(self);
+
+    PyObject* result = attributes->has(Attributes::field_value) ? attributes->value : Py_None;
+    Py_INCREF(result);
+    return result;
+}
+
+PyObject* get_status(PyObject* self, void*)
+{
+    return PyLong_FromLong(reinterpret_cast<Attributes*>(self)->status);
+}
+
+PyObject* get_severity(PyObject* self, void*)
+{
+    return PyLong_FromLong(reinterpret_cast<Attributes*>(self)->severity);
+}
+
+PyObject* get_timestamp(PyObject* self, void*)
+{
+    Attributes* attributes = reinterpret_cast<Attributes*>(self);
+
+    return Py_BuildValue("(II)", attributes->timestamp.secPastEpoch, attributes->timestamp.nsec);
+}
+
+PyObject* get_precision(PyObject* self, void*)
+{
+    Attributes* attributes = reinterpret_cast<Attributes*>(self);
+
+    if (not attributes->has(Attributes::field_precision)) Py_RETURN_NONE;
+    return PyLong_FromLong(attributes->precision);
+}
+
+PyObject* get_unit(PyObject* self, void*)
+{
+    Attributes* attributes = reinterpret_cast<Attributes*>(self);
+
+    if (not attributes->has(Attributes::field_unit)) Py_RETURN_NONE;
+    return PyBytes_FromStringAndSize(attributes->unit, attributes->unit_length);
+}
+
+PyObject* get_enum_strings(PyObject* self, void*)
+{
+    Attributes* attributes = reinterpret_cast<Attributes*>(self);
+
+    PyObject* result = attributes->has(Attributes::field_enum_strings) ? attributes->enum_strings : Py_None;
+    Py_INCREF(result);
+    return result;
+}
+
+PyObject* get_limits(PyObject* self, void* closure)
+{
+    Attributes* attributes = reinterpret_cast<Attributes*>(self);
+    LimitsKind kind = static_cast<LimitsKind>(reinterpret_cast<std::uintptr_t>(closure));
+
+    if (not attributes->hasLimits(kind)) Py_RETURN_NONE;
+    double const* limits = attributes->limits[static_cast<unsigned>(kind)];
+    return Py_BuildValue("(dd)", limits[0], limits[1]);
+}
+
+void* limits_closure(LimitsKind kind)
+{
+    return reinterpret_cast<void*>(static_cast<std::uintptr_t>(kind));
+}
+
+PyGetSetDef attributes_getset[] = {
+    {const_cast<char*>("value"),          get_value,        nullptr, const_cast<char*>("Value or ``None``."), nullptr},
+    {const_cast<char*>("status"),         get_status,       nullptr, const_cast<char*>("Status as integer."), nullptr},
+    {const_cast<char*>("severity"),       get_severity,     nullptr, const_cast<char*>("Severity as integer."), nullptr},
+    {const_cast<char*>("timestamp"),      get_timestamp,    nullptr, const_cast<char*>("Timestamp as ``(seconds, nanoseconds)`` tuple since the epics epoch."), nullptr},
+    {const_cast<char*>("precision"),      get_precision,    nullptr, const_cast<char*>("Precision or ``None``."), nullptr},
+    {const_cast<char*>("unit"),           get_unit,         nullptr, const_cast<char*>("Unit or ``None``."), nullptr},
+    {const_cast<char*>("enum_strings"),   get_enum_strings, nullptr, const_cast<char*>("Enumeration strings or ``None``."), nullptr},
+    {const_cast<char*>("display_limits"), get_limits,       nullptr, const_cast<char*>("Display limits or ``None``."), limits_closure(LimitsKind::display)},
+    {const_cast<char*>("warning_limits"), get_limits,       nullptr, const_cast<char*>("Warning limits or ``None``."), limits_closure(LimitsKind::warning)},
+    {const_cast<char*>("alarm_limits"),   get_limits,       nullptr, const_cast<char*>("Alarm limits or ``None``."), limits_closure(LimitsKind::alarm)},
+    {const_cast<char*>("control_limits"), get_limits,       nullptr, const_cast<char*>("Control limits or ``None``."), limits_closure(LimitsKind::control)},
+    {nullptr}
+};
+
+PyDoc_STRVAR(attributes__doc__, R"(Attributes(*, value=None, status=0, severity=0, timestamp=None, precision=None, unit=None, enum_strings=None, display_limits=None, warning_limits=None, alarm_limits=None, control_limits=None)
+
+Immutable attributes object.
+
+Can be used everywhere an attributes dictionary is expected. All
+attributes except ``value`` and ``enum_strings`` are converted to
+native types when the object is created, so converting it for the
+server only needs a few field reads.
+
+Args:
+    value: The value, encoded like in an attributes dictionary.
+    status (int|:class:`channel_access.common.Status`): Status.
+    severity (int|:class:`channel_access.common.Severity`): Severity.
+    timestamp: A :class:`datetime.datetime` (naive datetimes are UTC),
+        a POSIX timestamp or a ``(seconds, nanoseconds)`` tuple since
+        the epics epoch. ``None`` uses the current time.
+    precision (int): Precision.
+    unit (bytes): Unit.
+    enum_strings (tuple): Tuple of bytes objects.
+    display_limits (tuple): ``(lower, upper)`` tuple.
+    warning_limits (tuple): ``(lower, upper)`` tuple.
+    alarm_limits (tuple): ``(lower, upper)`` tuple.
+    control_limits (tuple): ``(lower, upper)`` tuple.
+)");
+PyTypeObject attributes_type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    "ca_server.cas.Attributes",                /* tp_name */
+    sizeof(Attributes),                        /* tp_basicsize */
+    0,                                         /* tp_itemsize */
+    attributes_dealloc,                        /* tp_dealloc */
+    0,                                         /* tp_vectorcall_offset */
+    nullptr,                                   /* tp_getattr */
+    nullptr,                                   /* tp_setattr */
+    nullptr,                                   /* tp_as_async */
+    nullptr,                                   /* tp_repr */
+    nullptr,                                   /* tp_as_number */
+    nullptr,                                   /* tp_as_sequence */
+    nullptr,                                   /* tp_as_mapping */
+    nullptr,                                   /* tp_hash */
+    nullptr,                                   /* tp_call */
+    nullptr,                                   /* tp_str */
+    nullptr,                                   /* tp_getattro */
+    nullptr,                                   /* tp_setattro */
+    nullptr,                                   /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                        /* tp_flags */
+    attributes__doc__,                         /* tp_doc */
+    nullptr,                                   /* tp_traverse */
+    nullptr,                                   /* tp_clear */
+    nullptr,                                   /* tp_richcompare */
+    0,                                         /* tp_weaklistoffset */
+    nullptr,                                   /* tp_iter */
+    nullptr,                                   /* tp_iternext */
+    nullptr,                                   /* tp_methods */
+    nullptr,                                   /* tp_members */
+    attributes_getset,                         /* tp_getset */
+    nullptr,                                   /* tp_base */
+    nullptr,                                   /* tp_dict */
+    nullptr,                                   /* tp_descr_get */
+    nullptr,                                   /* tp_descr_set */
+    0,                                         /* tp_dictoffset */
+    nullptr,                                   /* tp_init */
+    nullptr,                                   /* tp_alloc */
+    attributes_new,                            /* tp_new */
+};
+
+}
+
+PyObject* create_attributes_type()
+{
+    PyDateTime_IMPORT;
+    if (not PyDateTimeAPI) return nullptr;
+
+    if (PyType_Ready(&attributes_type) < 0) return nullptr;
+
+    Py_INCREF(&attributes_type);
+    return reinterpret_cast<PyObject*>(&attributes_type);
+}
+
+void destroy_attributes_type()
+{
+    Py_DECREF(&attributes_type);
+}
+
+Attributes const* as_attributes(PyObject* obj)
+{
+    if (not PyObject_TypeCheck(obj, &attributes_type)) return nullptr;
+    return reinterpret_cast<Attributes const*>(obj);
+}
+
+char const* limits_name(LimitsKind kind)
+{
+    return limits_names[static_cast<unsigned>(kind)];
+}
+
+bool enum_to_int(PyObject* obj, int& result)
+{
+    if (PyLong_Check(obj)) {
+        result = PyLong_AsLong(obj);
+        return not PyErr_Occurred();
+    }
+
+    PyObject* py_val = PyObject_GetAttrString(obj, "value");
+    if (not py_val) return false;
+
+    result = PyLong_AsLong(py_val);
+    Py_DECREF(py_val);
+    return not PyErr_Occurred();
+}
+
+bool to_epics_timestamp(PyObject* obj, epicsTimeStamp& timestamp)
+{
+    if (obj == Py_None) {
+        epicsTimeGetCurrent(&timestamp);
+        return true;
+    }
+
+    if (PyDateTime_Check(obj)) {
+        return datetime_to_timestamp(obj, timestamp);
+    }
+
+    if (PyTuple_Check(obj)) {
+        unsigned long seconds, nsec;
+        if (not PyArg_ParseTuple(obj, "kk;timestamp must be a (seconds, nanoseconds) tuple", &seconds, &nsec)) return false;
+        if (nsec >= 1000000000ul) {
+            PyErr_SetString(PyExc_ValueError, "Nanoseconds of the timestamp out of range");
+            return false;
+        }
+
+        timestamp.secPastEpoch = seconds;
+        timestamp.nsec = nsec;
+        return true;
+    }
+
+    double posix = PyFloat_AsDouble(obj);
+    if (PyErr_Occurred()) return false;
+
+    double seconds = std::floor(posix);
+    return posix_to_timestamp(static_cast<long long>(seconds), static_cast<long>((posix - seconds) * 1e9), timestamp);
+}
+
+}
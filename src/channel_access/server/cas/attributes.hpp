@@ -0,0 +1,92 @@
+#ifndef INCLUDE_GUARD_ED76F334_2B94_4061_B264_31931BFCDAD3
+#define INCLUDE_GUARD_ED76F334_2B94_4061_B264_31931BFCDAD3
+
+#include <type_traits>
+#include <Python.h>
+#include <db_access.h>
+#include <epicsTime.h>
+
+namespace cas {
+
+/** Kinds of limits stored in an Attributes object.
+ */
+enum class LimitsKind {
+    display = 0,
+    warning = 1,
+    alarm = 2,
+    control = 3
+};
+
+/** Native attributes object.
+ *
+ * Holds the attributes of a PV in fixed slots with everything except the
+ * value and the enum strings already converted to C types. Objects are
+ * immutable, so they can be shared without locking.
+ */
+struct Attributes {
+    PyObject_HEAD
+    // Bit mask of the fields which are set, see ``Attributes::has()``
+    unsigned fields;
+    PyObject* value;
+    int status;
+    int severity;
+    epicsTimeStamp timestamp;
+    short precision;
+    char unit[MAX_STRING_SIZE];
+    unsigned unit_length;
+    PyObject* enum_strings;
+    double limits[4][2];
+
+    enum Field : unsigned {
+        field_value = 1 << 0,
+        field_precision = 1 << 1,
+        field_unit = 1 << 2,
+        field_enum_strings = 1 << 3,
+        field_limits = 1 << 4
+    };
+
+    bool has(unsigned field) const
+    {
+        return fields & field;
+    }
+
+    bool hasLimits(LimitsKind kind) const
+    {
+        return fields & (field_limits << static_cast<unsigned>(kind));
+    }
+};
+static_assert(std::is_standard_layout<Attributes>::value, "Attributes has to be standard layout to work with the Python API");
+
+/** Create the Attributes type.
+ * Returns new reference.
+ */
+PyObject* create_attributes_type();
+
+/** Destroy the Attributes type.
+ */
+void destroy_attributes_type();
+
+/** Return ``obj`` as Attributes object or ``nullptr`` if it is none.
+ * Does not set an exception.
+ */
+Attributes const* as_attributes(PyObject* obj);
+
+/** Return the name of the limits attribute, e.g. ``"display_limits"``.
+ */
+char const* limits_name(LimitsKind kind);
+
+/** Convert an integer or an enum member (e.g. a status) to an integer.
+ */
+bool enum_to_int(PyObject* obj, int& result);
+
+/** Convert a timestamp to an epics timestamp.
+ *
+ * Accepts datetimes (naive datetimes are UTC), POSIX timestamps and
+ * ``(seconds, nanoseconds)`` tuples relative to the epics epoch.
+ * ``None`` is the current time.
+ */
+bool to_epics_timestamp(PyObject* obj, epicsTimeStamp& timestamp);
+
+}
+
+#endif
@@ -12,6 +12,11 @@
 #include "server.hpp"
 #include "pv.hpp"
 #include "async.hpp"
+#include "attributes.hpp"
+#include "convert.hpp"
+#include "event_queue.hpp"
+#include "limits.hpp"
+#include "server_thread.hpp"
 
 namespace cas {
 
@@ -24,24 +29,225 @@ PyObject* enum_attach = nullptr;
 
 namespace {
 
+// Longest wait in process() while the event queue is enabled
+constexpr double event_queue_latency = 0.01;
+
 PyDoc_STRVAR(process__doc__, R"(process(timeout)
 
 Process server io for at most ``timeout`` seconds.
+
+Events in the event queue (see :func:`setEventQueue`) are posted before
+and after processing. While the queue is enabled this waits at most
+10 ms so that queued events are not delayed for long.
+
+Do not call this while the thread started by :func:`startThread`
+is running.
 )");
 PyObject* process(PyObject* module, PyObject* arg)
 {
     double timeout = PyFloat_AsDouble(arg);
     if (PyErr_Occurred()) return nullptr;
 
+    EventQueue const* queue = event_queue();
+    if (queue and queue->enabled() and timeout > event_queue_latency) {
+        timeout = event_queue_latency;
+    }
+
     Py_BEGIN_ALLOW_THREADS
+        ProcessScope scope;
+        drain_event_queue();
         fileDescriptorManager.process(timeout);
+        drain_event_queue();
     Py_END_ALLOW_THREADS
 
+    // Arrays released by the server while processing
+    release_deferred_references();
+
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(apply_limits__doc__, R"(applyLimits(value, control_limits, warning_limits, alarm_limits)
+
+Apply the limits of a PV to a number or an array of numbers.
+
+The limits are ``(low, high)`` tuples or ``None``, limits with
+``low >= high`` are ignored.
+
+Return a tuple ``(value, status, severity)``. ``value`` is clamped to the
+control limits: elements outside are replaced by the limit, sequences
+become tuples and numpy arrays keep their dtype. A numpy array is only
+copied if an element is outside of the limits, the argument is never
+changed. Status and severity are calculated from the extreme values
+and the warning and alarm limits.
+)");
+PyObject* apply_limits(PyObject* module, PyObject* args)
+{
+    PyObject* value, *control_limits, *warning_limits, *alarm_limits;
+    if (not PyArg_ParseTuple(args, "OOOO", &value, &control_limits, &warning_limits, &alarm_limits)) return nullptr;
+
+    Limits control, warning, alarm;
+    if (not to_limits(control_limits, control)) return nullptr;
+    if (not to_limits(warning_limits, warning)) return nullptr;
+    if (not to_limits(alarm_limits, alarm)) return nullptr;
+
+    PyObject* result;
+    int status, severity;
+    if (not cas::apply_limits(value, control, warning, alarm, result, status, severity)) return nullptr;
+
+    return Py_BuildValue("(NNN)", result,
+        PyObject_CallFunction(enum_status, "i", status),
+        PyObject_CallFunction(enum_severity, "i", severity));
+}
+
+PyDoc_STRVAR(value_events__doc__, R"(valueEvents(value, old_value, relative_tolerance, absolute_tolerance, value_deadband, archive_deadband)
+
+Compare a number or an array of numbers with the old value.
+
+Return a tuple ``(changed, events)``. ``changed`` is ``False`` if all
+elements are close within the tolerances, like :func:`math.isclose`.
+``events`` is the integer mask of the :class:`channel_access.common.Events`
+``VALUE`` and ``ARCHIVE`` for which the largest absolute difference
+reaches the deadband. NaNs are equal to each other and infinitely
+different from numbers.
+)");
+PyObject* value_events(PyObject* module, PyObject* args)
+{
+    PyObject* value, *old_value;
+    Deadbands deadbands;
+    if (not PyArg_ParseTuple(args, "OOdddd", &value, &old_value,
+            &deadbands.relative_tolerance, &deadbands.absolute_tolerance,
+            &deadbands.value, &deadbands.archive)) return nullptr;
+
+    bool changed;
+    unsigned events;
+    if (not cas::value_events(value, old_value, deadbands, changed, events)) return nullptr;
+
+    return Py_BuildValue("(NI)", PyBool_FromLong(changed), events);
+}
+
+PyDoc_STRVAR(start_thread__doc__, R"(startThread()
+
+Start a native thread processing server io.
+
+The thread runs the same loop as :func:`process` without holding the
+GIL, it only takes it for callbacks into Python. It sleeps until there
+is io, a timer expires or it is woken up for queued events.
+
+The thread is shared, every call must be paired with a call to
+:func:`stopThread`.
+)");
+PyObject* start_thread(PyObject* module, PyObject*)
+{
+    bool success;
+    Py_BEGIN_ALLOW_THREADS
+        success = start_process_thread();
+    Py_END_ALLOW_THREADS
+    if (not success) {
+        PyErr_SetString(PyExc_RuntimeError, "Could not start the server thread");
+        return nullptr;
+    }
     Py_RETURN_NONE;
 }
 
+PyDoc_STRVAR(stop_thread__doc__, R"(stopThread(force=False)
+
+Stop the native thread started with :func:`startThread`.
+
+The thread stops when the last :func:`startThread` call is paired, or
+immediately if ``force`` is ``True``. This waits until the thread
+has stopped, except when it is called from a callback on the thread itself.
+)");
+PyObject* stop_thread(PyObject* module, PyObject* args, PyObject* kwds)
+{
+    static char const* keywords[] = {"force", nullptr};
+    int force = 0;
+    if (not PyArg_ParseTupleAndKeywords(args, kwds, "|p:stopThread", const_cast<char**>(keywords), &force)) return nullptr;
+
+    // The thread might wait for the GIL in a callback
+    Py_BEGIN_ALLOW_THREADS
+        stop_process_thread(force);
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(set_event_queue__doc__, R"(setEventQueue(capacity)
+
+Enable or disable the event queue.
+
+While the queue is enabled events posted from other threads than the
+one calling :func:`process` are not posted directly. They are put into
+a lock-free queue with ``capacity`` slots and posted by :func:`process`,
+so producer threads do not contend with the server for its locks. When
+the queue is full the event is posted directly after the queued events
+of the same PV. ``0`` disables the queue and posts the queued events.
+
+The queue is shared by all servers. It is created once, its capacity can
+not be changed later. ``capacity`` is rounded up to a power of two.
+
+This function is thread-safe.
+
+Args:
+    capacity (int): Number of slots, ``0`` to disable the queue.
+)");
+PyObject* set_event_queue(PyObject* module, PyObject* arg)
+{
+    Py_ssize_t capacity = PyNumber_AsSsize_t(arg, PyExc_OverflowError);
+    if (capacity == -1 and PyErr_Occurred()) return nullptr;
+    if (capacity < 0) {
+        PyErr_SetString(PyExc_ValueError, "capacity must not be negative");
+        return nullptr;
+    }
+
+    bool success;
+    Py_BEGIN_ALLOW_THREADS
+        success = configure_event_queue(capacity);
+    Py_END_ALLOW_THREADS
+    if (not success) {
+        PyErr_SetString(PyExc_ValueError, "The capacity of the event queue can not be changed");
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(event_queue_statistics__doc__, R"(eventQueueStatistics()
+
+Return statistics of the event queue.
+
+This function is thread-safe.
+
+Returns:
+    dict: A dictionary with the keys ``enabled``, ``capacity`` (number
+    of slots), ``depth`` (number of events currently queued),
+    ``high_water`` (largest depth so far), ``posted`` (number of events
+    posted from the queue) and ``overflows`` (number of events posted
+    directly because the queue was full).
+)");
+PyObject* event_queue_statistics(PyObject* module, PyObject*)
+{
+    EventQueue const* queue = event_queue();
+    if (not queue) {
+        return Py_BuildValue("{sOsnsnsnsKsK}",
+            "enabled", Py_False, "capacity", Py_ssize_t{0}, "depth", Py_ssize_t{0},
+            "high_water", Py_ssize_t{0}, "posted", 0ULL, "overflows", 0ULL);
+    }
+
+    return Py_BuildValue("{sOsnsnsnsKsK}",
+        "enabled", queue->enabled() ? Py_True : Py_False,
+        "capacity", static_cast<Py_ssize_t>(queue->capacity()),
+        "depth", static_cast<Py_ssize_t>(queue->depth()),
+        "high_water", static_cast<Py_ssize_t>(queue->highWater()),
+        "posted", static_cast<unsigned long long>(queue->posted()),
+        "overflows", static_cast<unsigned long long>(queue->overflows()));
+}
+
 PyMethodDef methods[] = {
     {"process", process, METH_O, process__doc__},
+    {"startThread", start_thread, METH_NOARGS, start_thread__doc__},
+    {"stopThread", reinterpret_cast<PyCFunction>(stop_thread), METH_VARARGS | METH_KEYWORDS, stop_thread__doc__},
+    {"setEventQueue", set_event_queue, METH_O, set_event_queue__doc__},
+    {"eventQueueStatistics", event_queue_statistics, METH_NOARGS, event_queue_statistics__doc__},
+    {"applyLimits", apply_limits, METH_VARARGS, apply_limits__doc__},
+    {"valueEvents", value_events, METH_VARARGS, value_events__doc__},
     {nullptr}   /* Sentinel */
 };
 
@@ -124,7 +330,9 @@ PyMODINIT_FUNC PyInit_cas(void)
     int result = -1;
     PyObject* module = nullptr, *server_type = nullptr, *pv_type = nullptr;
     PyObject* async_read_type = nullptr, *async_write_type = nullptr;
+    PyObject* async_exist_type = nullptr, *async_attach_type = nullptr;
     PyObject* async_context_type = nullptr, * ca_module = nullptr;
+    PyObject* attributes_type = nullptr;
     PyObject* enum_module = nullptr, *enum_class = nullptr;
 
     module = PyModule_Create(&cas::module);
@@ -186,6 +394,16 @@ PyMODINIT_FUNC PyInit_cas(void)
         goto error;
     }
 
+    attributes_type = cas::create_attributes_type();
+    if (not attributes_type) goto error;
+
+    result = PyModule_AddObject(module, "Attributes", attributes_type);
+    attributes_type = nullptr;
+    if (result != 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Could not add Attributes class");
+        goto error;
+    }
+
     async_context_type = cas::create_async_context_type();
     if (not async_context_type) goto error;
 
@@ -209,6 +427,26 @@ PyMODINIT_FUNC PyInit_cas(void)
         goto error;
     }
 
+    async_exist_type = cas::create_async_exist_type();
+    if (not async_exist_type) goto error;
+
+    result = PyModule_AddObject(module, "AsyncPVExist", async_exist_type);
+    async_exist_type = nullptr;
+    if (result != 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Could not add AsyncPVExist class");
+        goto error;
+    }
+
+    async_attach_type = cas::create_async_attach_type();
+    if (not async_attach_type) goto error;
+
+    result = PyModule_AddObject(module, "AsyncPVAttach", async_attach_type);
+    async_attach_type = nullptr;
+    if (result != 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Could not add AsyncPVAttach class");
+        goto error;
+    }
+
     Py_DECREF(enum_class);
     Py_DECREF(enum_module);
     Py_DECREF(ca_module);
@@ -217,9 +455,12 @@ PyMODINIT_FUNC PyInit_cas(void)
 error:
     Py_XDECREF(pv_type);
     Py_XDECREF(server_type);
+    Py_XDECREF(attributes_type);
     Py_XDECREF(async_context_type);
     Py_XDECREF(async_read_type);
     Py_XDECREF(async_write_type);
+    Py_XDECREF(async_exist_type);
+    Py_XDECREF(async_attach_type);
     Py_XDECREF(cas::enum_attach);
     Py_XDECREF(cas::enum_exists);
     Py_XDECREF(cas::enum_severity);
@@ -1,5 +1,8 @@
 #include "convert.hpp"
 
+#include <atomic>
+#include <cstring>
+#include <mutex>
 #include <vector>
 #include <unordered_map>
 #include <db_access.h>
@@ -15,10 +18,18 @@
 
 #include "cas.hpp"
 #include "pv.hpp"
+#include "attributes.hpp"
+#include "kernels.hpp"
+#include "server.hpp"
 
 namespace cas {
 namespace {
 
+// References dropped without the GIL, released by release_deferred_references()
+std::mutex deferred_mutex;
+std::vector<PyObject*> deferred_references;
+std::atomic<bool> has_deferred_references{false};
+
 PyObject* dict_get_item(PyObject* dict, char const* item)
 {
     PyObject* key = PyUnicode_FromString(item);
@@ -115,8 +126,53 @@ auto py_convert(T value) -> typename std::enable_if<std::is_floating_point<T>::v
     return PyFloat_FromDouble(value);
 }
 
+#if CA_SERVER_NUMPY_SUPPORT
+
+char const* const gdd_capsule_name = "channel_access.server.cas.gdd";
+
+void release_gdd_capsule(PyObject* capsule)
+{
+    auto const* value = static_cast<gdd const*>(PyCapsule_GetPointer(capsule, gdd_capsule_name));
+    if (value) {
+        value->unreference();
+    }
+}
+
+// Return a read-only numpy array using the data of ``value`` or nullptr
+// without exception if ``value`` can not be referenced.
 template <typename T>
-PyObject* write_value(gdd const& value, bool numpy)
+PyObject* numpy_view(gdd const& value, T const* data, npy_intp count)
+{
+    // Flat gdds (e.g. from a container) can not be referenced
+    if (value.reference() != 0) return nullptr;
+
+    PyObject* base = PyCapsule_New(const_cast<gdd*>(&value), gdd_capsule_name, release_gdd_capsule);
+    if (not base) {
+        value.unreference();
+        PyErr_Clear();
+        return nullptr;
+    }
+
+    npy_intp dims[1] = { count };
+    PyObject* array = PyArray_New(&PyArray_Type, 1, dims, numpy_array_type(data), nullptr,
+        const_cast<T*>(data), 0, NPY_ARRAY_CARRAY_RO, nullptr);
+    if (not array) {
+        Py_DECREF(base);
+        return nullptr;
+    }
+
+    // The array keeps the gdd referenced through the capsule, steals base
+    if (PyArray_SetBaseObject(reinterpret_cast<PyArrayObject*>(array), base) != 0) {
+        Py_DECREF(array);
+        return nullptr;
+    }
+    return array;
+}
+
+#endif
+
+template <typename T>
+PyObject* write_value(gdd const& value, bool numpy, bool view)
 {
     if (value.isScalar()) {
         return py_convert(static_cast<T>(value));
@@ -132,6 +188,10 @@ PyObject* write_value(gdd const& value, bool numpy)
 
         PyObject* list = nullptr;
 #if CA_SERVER_NUMPY_SUPPORT
+        if (numpy and view) {
+            list = numpy_view(value, &data[first], count);
+            if (list or PyErr_Occurred()) return list;
+        }
         if (numpy) {
             npy_intp dims[1] = { count };
             int typenum = numpy_array_type(data);
@@ -147,14 +207,21 @@ PyObject* write_value(gdd const& value, bool numpy)
             list = PyTuple_New(count);
             if (not list) return nullptr;
 
-            for (aitIndex i = first; i < count; ++i) {
-                PyObject* py_val = py_convert(static_cast<T>(data[i]));
-                if (not py_val) {
-                    Py_DECREF(list);
-                    return nullptr;
+            PyObject* py_val = nullptr;
+            for (aitIndex i = 0; i < count; ++i) {
+                // Waveforms often contain runs of equal values, share the objects.
+                // Compare the bits so -0.0 and 0.0 stay distinct.
+                if (py_val and std::memcmp(&data[first + i], &data[first + i - 1], sizeof(T)) == 0) {
+                    Py_INCREF(py_val);
+                } else {
+                    py_val = py_convert(static_cast<T>(data[first + i]));
+                    if (not py_val) {
+                        Py_DECREF(list);
+                        return nullptr;
+                    }
                 }
 
-                PyTuple_SET_ITEM(list, i - first, py_val);
+                PyTuple_SET_ITEM(list, i, py_val);
             }
         }
 
@@ -200,49 +267,93 @@ auto py_convert(PyObject* py_val, T& value) -> typename std::enable_if<std::is_f
     return not PyErr_Occurred();
 }
 
+// Converts an item of a sequence, checks the common exact types first
 template <typename T>
-bool read_value_impl(PyObject* value, aitEnum type, gdd& result)
+auto py_convert_item(PyObject* py_val, T& value) -> typename std::enable_if<std::is_integral<T>::value, bool>::type
 {
-    if (not PySequence_Check(value)) {
-        T val;
-        if (not py_convert(value, val)) return false;
+#if PY_VERSION_HEX >= 0x030C0000
+    if (PyLong_CheckExact(py_val) and PyUnstable_Long_IsCompact(reinterpret_cast<PyLongObject*>(py_val))) {
+        value = PyUnstable_Long_CompactValue(reinterpret_cast<PyLongObject*>(py_val));
+        return true;
+    }
+#endif
+    if (PyLong_CheckExact(py_val)) {
+        long const val = PyLong_AsLong(py_val);
+        if (val == -1 and PyErr_Occurred()) return false;
+        value = val;
+        return true;
+    }
+    return py_convert(py_val, value);
+}
 
-        result.setDimension(0, nullptr);
-        return result.put(val) == 0;
+template <typename T>
+auto py_convert_item(PyObject* py_val, T& value) -> typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+{
+    if (PyFloat_CheckExact(py_val)) {
+        value = PyFloat_AS_DOUBLE(py_val);
+        return true;
     }
+    return py_convert(py_val, value);
+}
 
-    Py_ssize_t size = PySequence_Size(value);
-    if (PyErr_Occurred()) return false;
+// Keeps a python object alive while a gdd references its data
+class ReferenceDestructor : public gddDestructor {
+public:
+    explicit ReferenceDestructor(PyObject* owner)
+        : owner{owner}
+    {}
 
-    std::vector<T> data;
-#if CA_SERVER_NUMPY_SUPPORT
-    if (PyArray_Check(value)) {
-        data.reserve(size);
-        int typenum = numpy_array_type(static_cast<const T*>(nullptr));
+    // Called when the last gdd releases the data, maybe without the GIL
+    void run(void*) override
+    {
+        defer_decref(owner);
+    }
 
-        PyObject* ndarray = PyArray_FROMANY(value, typenum, 1, 1, NPY_ARRAY_CARRAY | NPY_ARRAY_FORCECAST);
-        if (not ndarray) return false;
+private:
+    PyObject* owner;
+};
 
-        auto const* array_data = static_cast<const T*>(PyArray_DATA(reinterpret_cast<PyArrayObject*>(ndarray)));
-        data.assign(array_data, array_data + size);
-        Py_DECREF(ndarray);
-    } else
-#endif
-    {
-        data.resize(size);
-        for (Py_ssize_t i = 0; i < size; ++i) {
-            PyObject* item = PySequence_GetItem(value, i);
-            if (not item) return false;
-
-            bool res = py_convert(item, data[i]);
-            Py_DECREF(item);
-            if (not res) return false;
-        }
+// Let result reference ``size`` elements at ``data``, which belong to ``owner``.
+// Steals the reference to ``owner``.
+template <typename T>
+bool put_reference(T const* data, Py_ssize_t size, PyObject* owner, gdd& result)
+{
+    release_deferred_references();
+
+    if (size == 1) {
+        T const element = data[0];
+        Py_DECREF(owner);
+        result.setDimension(0, nullptr);
+        return result.put(element) == 0;
+    }
+
+    if (result.dimension() != 1) {
+        result.setDimension(1, nullptr);
     }
+    result.setBound(0, 0, size);
+
+    ReferenceDestructor* destructor = nullptr;
+    try {
+        destructor = new ReferenceDestructor{owner};
+    } catch (...) {
+        Py_DECREF(owner);
+        return false;
+    }
+
+    // The destructor owns the reference to owner now
+    result.putRef(data, destructor);
+    return true;
+}
+
+// Let result own the elements of data
+template <typename T>
+bool put_array(std::vector<T>&& data, gdd& result)
+{
+    Py_ssize_t const size = data.size();
 
     if (size == 1) {
         result.setDimension(0, nullptr);
-        return result.put(data[0]);
+        return result.put(data[0]) == 0;
     }
 
     if (result.dimension() != 1) {
@@ -261,6 +372,171 @@ bool read_value_impl(PyObject* value, aitEnum type, gdd& result)
     return true;
 }
 
+// bytes objects are immutable, CHAR arrays reference them directly
+bool read_bytes_value(PyObject* value, aitInt8 const*, gdd& result, bool& handled)
+{
+    handled = PyBytes_CheckExact(value);
+    if (not handled) return true;
+
+    Py_INCREF(value);
+    return put_reference(reinterpret_cast<aitInt8 const*>(PyBytes_AS_STRING(value)), PyBytes_GET_SIZE(value), value, result);
+}
+
+template <typename T>
+bool read_bytes_value(PyObject*, T const*, gdd&, bool& handled)
+{
+    handled = false;
+    return true;
+}
+
+// Buffers with at least this many elements are converted without the GIL
+constexpr std::size_t large_buffer_size = 1 << 16;
+
+template <typename From, typename T>
+void convert_buffer(void const* buffer, std::vector<T>& data)
+{
+    convert_elements(static_cast<From const*>(buffer), data.data(), data.size());
+}
+
+// Copy the elements of a C-contiguous buffer with native element types.
+// ``handled`` is false if value has no such buffer.
+template <typename T>
+bool read_buffer_value(PyObject* value, std::vector<T>& data, bool& handled)
+{
+    handled = false;
+    if (not PyObject_CheckBuffer(value)) return true;
+
+    Py_buffer view;
+    if (PyObject_GetBuffer(value, &view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) != 0) {
+        // Not contiguous, use the sequence protocol
+        PyErr_Clear();
+        return true;
+    }
+
+    // Only native sizes and byte order, e.g. "d" or "@i"
+    char const* format = view.format ? view.format : "B";
+    if (format[0] == '@') ++format;
+
+    void (*convert)(void const*, std::vector<T>&) = nullptr;
+    std::size_t item_size = 0;
+    if (format[0] != '\0' and format[1] == '\0') {
+        switch (format[0]) {
+            case 'b': convert = convert_buffer<signed char, T>;        item_size = sizeof(signed char);        break;
+            case 'B': convert = convert_buffer<unsigned char, T>;      item_size = sizeof(unsigned char);      break;
+            case '?': convert = convert_buffer<bool, T>;               item_size = sizeof(bool);               break;
+            case 'h': convert = convert_buffer<short, T>;              item_size = sizeof(short);              break;
+            case 'H': convert = convert_buffer<unsigned short, T>;     item_size = sizeof(unsigned short);     break;
+            case 'i': convert = convert_buffer<int, T>;                item_size = sizeof(int);                break;
+            case 'I': convert = convert_buffer<unsigned int, T>;       item_size = sizeof(unsigned int);       break;
+            case 'l': convert = convert_buffer<long, T>;               item_size = sizeof(long);               break;
+            case 'L': convert = convert_buffer<unsigned long, T>;      item_size = sizeof(unsigned long);      break;
+            case 'q': convert = convert_buffer<long long, T>;          item_size = sizeof(long long);          break;
+            case 'Q': convert = convert_buffer<unsigned long long, T>; item_size = sizeof(unsigned long long); break;
+            case 'f': convert = convert_buffer<float, T>;              item_size = sizeof(float);              break;
+            case 'd': convert = convert_buffer<double, T>;             item_size = sizeof(double);             break;
+        }
+    }
+
+    if (convert and static_cast<std::size_t>(view.itemsize) == item_size) {
+        data.resize(view.len / view.itemsize);
+        if (data.size() < large_buffer_size) {
+            convert(view.buf, data);
+        } else {
+            // Buffers can not contain python objects, no GIL needed
+            Py_BEGIN_ALLOW_THREADS
+                convert(view.buf, data);
+            Py_END_ALLOW_THREADS
+        }
+        handled = true;
+    }
+
+    PyBuffer_Release(&view);
+    return true;
+}
+
+#if CA_SERVER_NUMPY_SUPPORT
+
+template <typename T>
+bool read_numpy_value(PyObject* value, gdd& result)
+{
+    int typenum = numpy_array_type(static_cast<const T*>(nullptr));
+
+    // Other native numeric types are converted in one pass into the gdd buffer
+    if (PyArray_TYPE(reinterpret_cast<PyArrayObject*>(value)) != typenum and
+            PyArray_NDIM(reinterpret_cast<PyArrayObject*>(value)) == 1) {
+        std::vector<T> data;
+        bool handled;
+        if (not read_buffer_value(value, data, handled)) return false;
+        if (handled) return put_array(std::move(data), result);
+    }
+
+    // Returns value itself if it is contiguous and has the right type
+    PyObject* ndarray = PyArray_FROMANY(value, typenum, 1, 1, NPY_ARRAY_CARRAY_RO | NPY_ARRAY_FORCECAST);
+    if (not ndarray) return false;
+
+    // Only reference arrays nobody can change, copy all others once
+    auto* array = reinterpret_cast<PyArrayObject*>(ndarray);
+    if (ndarray == value and PyArray_ISWRITEABLE(array)) {
+        ndarray = PyArray_NewCopy(array, NPY_CORDER);
+        Py_DECREF(array);
+        if (not ndarray) return false;
+        array = reinterpret_cast<PyArrayObject*>(ndarray);
+    }
+
+    return put_reference(static_cast<T const*>(PyArray_DATA(array)), PyArray_SIZE(array), ndarray, result);
+}
+
+#endif
+
+template <typename T>
+bool read_value_impl(PyObject* value, aitEnum type, gdd& result)
+{
+    if (not PySequence_Check(value)) {
+        T val;
+        if (not py_convert(value, val)) return false;
+
+        result.setDimension(0, nullptr);
+        return result.put(val) == 0;
+    }
+
+#if CA_SERVER_NUMPY_SUPPORT
+    if (PyArray_Check(value)) {
+        return read_numpy_value<T>(value, result);
+    }
+#endif
+
+    bool handled;
+    if (not read_bytes_value(value, static_cast<T const*>(nullptr), result, handled)) return false;
+    if (handled) return true;
+
+    std::vector<T> data;
+    if (not read_buffer_value(value, data, handled)) return false;
+
+    if (not handled) {
+        // Borrowed items of lists and tuples, other sequences are copied once
+        PyObject* sequence = PySequence_Fast(value, "Value must be a sequence");
+        if (not sequence) return false;
+
+        Py_ssize_t const size = PySequence_Fast_GET_SIZE(sequence);
+        PyObject** items = PySequence_Fast_ITEMS(sequence);
+
+        bool success = true;
+        try {
+            data.resize(size);
+        } catch (...) {
+            PyErr_NoMemory();
+            success = false;
+        }
+        for (Py_ssize_t i = 0; success and i < size; ++i) {
+            success = py_convert_item(items[i], data[i]);
+        }
+        Py_DECREF(sequence);
+        if (not success) return false;
+    }
+
+    return put_array(std::move(data), result);
+}
+
 bool to_ait_string(PyObject* value, aitString& string)
 {
     if (not value) return false;
@@ -355,7 +631,7 @@ bool read_value(PyObject* value, aitEnum type, gdd& result)
         case aitEnumInt16:
             return read_value_impl<aitInt16>(value, type, result);
         case aitEnumInt32:
-            return read_value_impl<aitInt16>(value, type, result);
+            return read_value_impl<aitInt32>(value, type, result);
         case aitEnumFloat32:
             return read_value_impl<aitFloat32>(value, type, result);
         case aitEnumFloat64:
@@ -374,6 +650,11 @@ bool read_limits(PyObject* value, aitEnum type, gdd& lower, gdd& upper)
     return true;
 }
 
+//
+// Attribute sources. The attributes are either read from a dictionary
+// or from an Attributes object.
+//
+
 bool read_simple(PyObject* dict, aitEnum type, gdd& result)
 {
     PyObject* value = dict_get_item(dict, "value");
@@ -391,9 +672,8 @@ bool read_simple(PyObject* dict, aitEnum type, gdd& result)
     return true;
 }
 
-bool read_enums(PyObject* dict, gdd& result)
+bool read_enums(PyObject* enum_strings, gdd& result)
 {
-    PyObject* enum_strings = dict_get_item(dict, "enum_strings");
     if (not enum_strings) return false;
 
     Py_ssize_t size = PyTuple_Size(enum_strings);
@@ -413,71 +693,246 @@ bool read_enums(PyObject* dict, gdd& result)
     return true;
 }
 
-bool read_enum(PyObject* dict, aitEnum type, gdd& result)
+bool read_enum_strings(PyObject* dict, gdd& result)
 {
-    if (not read_simple(dict, type, result[gddAppTypeIndex_dbr_gr_enum_value])) return false;
-    if (not read_enums(dict, result[gddAppTypeIndex_dbr_gr_enum_enums])) return false;
+    return read_enums(dict_get_item(dict, "enum_strings"), result);
+}
 
-    return true;
+bool read_precision(PyObject* dict, gdd& result)
+{
+    return read_value(dict_get_item(dict, "precision"), aitEnumInt16, result);
 }
 
-bool read_gr(PyObject* dict, aitEnum type, gdd& result)
+bool read_unit(PyObject* dict, gdd& result)
 {
-    if (type == aitEnumFloat32 or type == aitEnumFloat64) {
-        if (not read_simple(dict, type, result[gddAppTypeIndex_dbr_gr_double_value])) return false;
+    return read_string(dict_get_item(dict, "unit"), result);
+}
 
-        PyObject* precision = dict_get_item(dict, "precision");
-        if (not read_value(precision, aitEnumInt16, result[gddAppTypeIndex_dbr_gr_double_precision])) return false;
-    } else {
-        if (not read_simple(dict, type, result[gddAppTypeIndex_dbr_gr_long_value])) return false;
+bool read_limits(PyObject* dict, LimitsKind kind, aitEnum type, gdd& lower, gdd& upper)
+{
+    PyObject* limits = dict_get_item(dict, limits_name(kind));
+    if (not limits) return false;
+
+    return read_limits(limits, type, lower, upper);
+}
+
+bool missing_attribute(char const* name)
+{
+    PyErr_Format(PyExc_KeyError, "'%s' not in attributes", name);
+    return false;
+}
+
+template <typename T>
+bool put_number(double value, gdd& result)
+{
+    result.setDimension(0, nullptr);
+    return result.put(static_cast<T>(value)) == 0;
+}
+
+bool put_number(double value, aitEnum type, gdd& result)
+{
+    switch (type) {
+        case aitEnumEnum16:
+            return put_number<aitEnum16>(value, result);
+        case aitEnumInt8:
+            return put_number<aitInt8>(value, result);
+        case aitEnumInt16:
+            return put_number<aitInt16>(value, result);
+        case aitEnumInt32:
+            return put_number<aitInt32>(value, result);
+        case aitEnumFloat32:
+            return put_number<aitFloat32>(value, result);
+        case aitEnumFloat64:
+            return put_number<aitFloat64>(value, result);
+        default:
+            PyErr_SetString(PyExc_RuntimeError, "Unhandled gdd type");
+            return false;
     }
+}
 
-    PyObject* unit = dict_get_item(dict, "unit");
-    if (not read_string(unit, result[gddAppTypeIndex_dbr_gr_double_units])) return false;
+bool read_simple(Attributes const* attributes, aitEnum type, gdd& result)
+{
+    if (not attributes->has(Attributes::field_value)) return missing_attribute("value");
+    if (not read_value(attributes->value, type, result)) return false;
 
-    PyObject* display_limits = dict_get_item(dict, "display_limits");
-    if (not read_limits(display_limits, type, result[gddAppTypeIndex_dbr_gr_double_graphicLow], result[gddAppTypeIndex_dbr_gr_double_graphicHigh])) return false;
+    result.setStatSevr(attributes->status, attributes->severity);
+    result.setTimeStamp(&attributes->timestamp);
+    return true;
+}
 
-    PyObject* warning_limits = dict_get_item(dict, "warning_limits");
-    if (not read_limits(warning_limits, type, result[gddAppTypeIndex_dbr_gr_double_alarmLowWarning], result[gddAppTypeIndex_dbr_gr_double_alarmHighWarning])) return false;
+bool read_enum_strings(Attributes const* attributes, gdd& result)
+{
+    if (not attributes->has(Attributes::field_enum_strings)) return missing_attribute("enum_strings");
+    return read_enums(attributes->enum_strings, result);
+}
+
+bool read_precision(Attributes const* attributes, gdd& result)
+{
+    if (not attributes->has(Attributes::field_precision)) return missing_attribute("precision");
+
+    result.setDimension(0, nullptr);
+    return result.put(static_cast<aitInt16>(attributes->precision)) == 0;
+}
 
-    PyObject* alarm_limits = dict_get_item(dict, "alarm_limits");
-    if (not read_limits(alarm_limits, type, result[gddAppTypeIndex_dbr_gr_double_alarmLow], result[gddAppTypeIndex_dbr_gr_double_alarmHigh])) return false;
+bool read_unit(Attributes const* attributes, gdd& result)
+{
+    if (not attributes->has(Attributes::field_unit)) return missing_attribute("unit");
+
+    aitString unit;
+    unit.copy(attributes->unit, attributes->unit_length);
+    return result.put(unit) == 0;
+}
+
+bool read_limits(Attributes const* attributes, LimitsKind kind, aitEnum type, gdd& lower, gdd& upper)
+{
+    if (not attributes->hasLimits(kind)) return missing_attribute(limits_name(kind));
+
+    double const* limits = attributes->limits[static_cast<unsigned>(kind)];
+    return put_number(limits[0], type, lower) and put_number(limits[1], type, upper);
+}
+
+//
+// Containers, ``Source`` is one of the attribute sources above.
+//
+
+template <typename Source>
+bool read_enum(Source source, aitEnum type, gdd& result)
+{
+    if (not read_simple(source, type, result[gddAppTypeIndex_dbr_gr_enum_value])) return false;
+    if (not read_enum_strings(source, result[gddAppTypeIndex_dbr_gr_enum_enums])) return false;
 
     return true;
 }
 
-bool read_ctrl(PyObject* dict, aitEnum type, gdd& result)
+template <typename Source>
+bool read_gr(Source source, aitEnum type, gdd& result)
 {
     if (type == aitEnumFloat32 or type == aitEnumFloat64) {
-        if (not read_simple(dict, type, result[gddAppTypeIndex_dbr_ctrl_double_value])) return false;
+        if (not read_simple(source, type, result[gddAppTypeIndex_dbr_gr_double_value])) return false;
+        if (not read_precision(source, result[gddAppTypeIndex_dbr_gr_double_precision])) return false;
+    } else {
+        if (not read_simple(source, type, result[gddAppTypeIndex_dbr_gr_long_value])) return false;
+    }
 
-        PyObject* precision = dict_get_item(dict, "precision");
-        if (not read_value(precision, aitEnumInt16, result[gddAppTypeIndex_dbr_ctrl_double_precision])) return false;
+    if (not read_unit(source, result[gddAppTypeIndex_dbr_gr_double_units])) return false;
+    if (not read_limits(source, LimitsKind::display, type, result[gddAppTypeIndex_dbr_gr_double_graphicLow], result[gddAppTypeIndex_dbr_gr_double_graphicHigh])) return false;
+    if (not read_limits(source, LimitsKind::warning, type, result[gddAppTypeIndex_dbr_gr_double_alarmLowWarning], result[gddAppTypeIndex_dbr_gr_double_alarmHighWarning])) return false;
+    if (not read_limits(source, LimitsKind::alarm, type, result[gddAppTypeIndex_dbr_gr_double_alarmLow], result[gddAppTypeIndex_dbr_gr_double_alarmHigh])) return false;
+
+    return true;
+}
+
+template <typename Source>
+bool read_ctrl(Source source, aitEnum type, gdd& result)
+{
+    if (type == aitEnumFloat32 or type == aitEnumFloat64) {
+        if (not read_simple(source, type, result[gddAppTypeIndex_dbr_ctrl_double_value])) return false;
+        if (not read_precision(source, result[gddAppTypeIndex_dbr_ctrl_double_precision])) return false;
     } else {
-        if (not read_simple(dict, type, result[gddAppTypeIndex_dbr_ctrl_long_value])) return false;
+        if (not read_simple(source, type, result[gddAppTypeIndex_dbr_ctrl_long_value])) return false;
     }
 
-    PyObject* unit = dict_get_item(dict, "unit");
-    if (not read_string(unit, result[gddAppTypeIndex_dbr_ctrl_double_units])) return false;
+    if (not read_unit(source, result[gddAppTypeIndex_dbr_ctrl_double_units])) return false;
+    if (not read_limits(source, LimitsKind::display, type, result[gddAppTypeIndex_dbr_ctrl_double_graphicLow], result[gddAppTypeIndex_dbr_ctrl_double_graphicHigh])) return false;
+    if (not read_limits(source, LimitsKind::warning, type, result[gddAppTypeIndex_dbr_ctrl_double_alarmLowWarning], result[gddAppTypeIndex_dbr_ctrl_double_alarmHighWarning])) return false;
+    if (not read_limits(source, LimitsKind::alarm, type, result[gddAppTypeIndex_dbr_ctrl_double_alarmLow], result[gddAppTypeIndex_dbr_ctrl_double_alarmHigh])) return false;
+    if (not read_limits(source, LimitsKind::control, type, result[gddAppTypeIndex_dbr_ctrl_double_controlLow], result[gddAppTypeIndex_dbr_ctrl_double_controlHigh])) return false;
+
+    return true;
+}
+
+template <typename Source>
+bool read_attributes(Source source, aitEnum type, gdd &result)
+{
+    int app = result.applicationType();
 
-    PyObject* display_limits = dict_get_item(dict, "display_limits");
-    if (not read_limits(display_limits, type, result[gddAppTypeIndex_dbr_ctrl_double_graphicLow], result[gddAppTypeIndex_dbr_ctrl_double_graphicHigh])) return false;
+    switch (app) {
+        // STS and TIME are also gddAppType_value because status, severity and
+        // timestamp are stored in the gdd itself.
+        // All STRING types are also gddAppType_value
+        case gddAppType_value:
+            return read_simple(source, type, result);
+        case gddAppType_enums:
+            return read_enum_strings(source, result);
 
-    PyObject* warning_limits = dict_get_item(dict, "warning_limits");
-    if (not read_limits(warning_limits, type, result[gddAppTypeIndex_dbr_ctrl_double_alarmLowWarning], result[gddAppTypeIndex_dbr_ctrl_double_alarmHighWarning])) return false;
+        case gddAppType_dbr_gr_enum:
+            return read_enum(source, type, result);
+        case gddAppType_dbr_gr_char:
+            return read_gr(source, type, result);
+        case gddAppType_dbr_gr_short:
+            return read_gr(source, type, result);
+        case gddAppType_dbr_gr_long:
+            return read_gr(source, type, result);
+        case gddAppType_dbr_gr_float:
+            return read_gr(source, type, result);
+        case gddAppType_dbr_gr_double:
+            return read_gr(source, type, result);
 
-    PyObject* alarm_limits = dict_get_item(dict, "alarm_limits");
-    if (not read_limits(alarm_limits, type, result[gddAppTypeIndex_dbr_ctrl_double_alarmLow], result[gddAppTypeIndex_dbr_ctrl_double_alarmHigh])) return false;
+        case gddAppType_dbr_ctrl_enum:
+            return read_enum(source, type, result);
+        case gddAppType_dbr_ctrl_char:
+            return read_ctrl(source, type, result);
+        case gddAppType_dbr_ctrl_short:
+            return read_ctrl(source, type, result);
+        case gddAppType_dbr_ctrl_long:
+            return read_ctrl(source, type, result);
+        case gddAppType_dbr_ctrl_float:
+            return read_ctrl(source, type, result);
+        case gddAppType_dbr_ctrl_double:
+            return read_ctrl(source, type, result);
+    }
 
-    PyObject* control_limits = dict_get_item(dict, "control_limits");
-    if (not read_limits(control_limits, type, result[gddAppTypeIndex_dbr_ctrl_double_controlLow], result[gddAppTypeIndex_dbr_ctrl_double_controlHigh])) return false;
+    char* app_name = gddApplicationTypeTable::app_table.getName(app);
+    if (app_name) {
+        PyErr_Format(PyExc_RuntimeError, "Unhandled gdd application type: %s", app_name);
+    } else {
+        PyErr_SetString(PyExc_RuntimeError, "Unhandled gdd application type");
+    }
+    return false;
+}
 
-    return true;
+// Return the gdd holding the value, status, severity and timestamp or
+// nullptr if ``result`` only requests meta data.
+gdd* value_member(gdd& result)
+{
+    if (result.applicationType() == gddAppType_value) return &result;
+    if (not result.isContainer()) return nullptr;
+
+    aitUint32 index;
+    if (gddApplicationTypeTable::app_table.mapAppToIndex(result.applicationType(), gddAppType_value, index) != 0) return nullptr;
+    return &result[index];
 }
 
 } // namespace
 
+void defer_decref(PyObject* obj)
+{
+    std::lock_guard<std::mutex> lock(deferred_mutex);
+    deferred_references.push_back(obj);
+    has_deferred_references = true;
+}
+
+void release_deferred_references()
+{
+    if (not has_deferred_references) return;
+
+    std::vector<PyObject*> references;
+    {
+        std::lock_guard<std::mutex> lock(deferred_mutex);
+        references.swap(deferred_references);
+        has_deferred_references = false;
+    }
+
+    for (PyObject* obj : references) {
+        Py_DECREF(obj);
+    }
+}
+
+bool has_deferred_decrefs()
+{
+    return has_deferred_references;
+}
+
 bool to_exist_return(PyObject* value, pvExistReturn& result)
 {
     if (not value) return false;
@@ -495,6 +950,15 @@ bool to_exist_return(PyObject* value, pvExistReturn& result)
             return true;
         }
         case 0: {
+            if (PyBool_Check(value)) {
+                result = pvExistReturn{value == Py_True ? pverExistsHere : pverDoesNotExistHere};
+                return true;
+            }
+            if (not PyTuple_Check(value) or PyTuple_GET_SIZE(value) != 2) {
+                PyErr_SetString(PyExc_TypeError, "Return value must be an ExistsResponse, a bool or an (ip, port) tuple");
+                return false;
+            }
+
             PyObject* host_item = PyTuple_GetItem(value, 0);
             if (not host_item) return false;
 
@@ -594,58 +1058,95 @@ bool to_ait_enum(PyObject* value, aitEnum& result)
     return true;
 }
 
-bool to_gdd(PyObject* dict, aitEnum type, gdd &result)
+gdd* create_attributes_gdd(aitEnum type)
 {
-    if (not dict) return false;
+    unsigned app;
+    switch (type) {
+        case aitEnumString:
+            // Strings have no meta data
+            return new gddScalar{gddAppType_value, aitEnumString};
+        case aitEnumEnum16:
+            app = gddAppType_dbr_ctrl_enum;
+            break;
+        case aitEnumInt8:
+            app = gddAppType_dbr_ctrl_char;
+            break;
+        case aitEnumInt16:
+            app = gddAppType_dbr_ctrl_short;
+            break;
+        case aitEnumInt32:
+            app = gddAppType_dbr_ctrl_long;
+            break;
+        case aitEnumFloat32:
+            app = gddAppType_dbr_ctrl_float;
+            break;
+        case aitEnumFloat64:
+            app = gddAppType_dbr_ctrl_double;
+            break;
+        default:
+            PyErr_SetString(PyExc_RuntimeError, "Unhandled gdd type");
+            return nullptr;
+    }
 
-    int app = result.applicationType();
+    gdd* result = gddApplicationTypeTable::app_table.getDD(app);
+    if (not result) {
+        PyErr_SetString(PyExc_RuntimeError, "Could not create gdd container");
+    }
+    return result;
+}
 
-    switch (app) {
-        // STS and TIME are also gddAppType_value because status, severity and
-        // timestamp are stored in the gdd itself.
-        // All STRING types are also gddAppType_value
-        case gddAppType_value:
-            return read_simple(dict, type, result);
-        case gddAppType_enums:
-            return read_enums(dict, result);
+bool copy_metadata(gdd const& metadata, gdd& result)
+{
+    if (result.applicationType() == gddAppType_value) return true;
 
-        case gddAppType_dbr_gr_enum:
-            return read_enum(dict, type, result);
-        case gddAppType_dbr_gr_char:
-            return read_gr(dict, type, result);
-        case gddAppType_dbr_gr_short:
-            return read_gr(dict, type, result);
-        case gddAppType_dbr_gr_long:
-            return read_gr(dict, type, result);
-        case gddAppType_dbr_gr_float:
-            return read_gr(dict, type, result);
-        case gddAppType_dbr_gr_double:
-            return read_gr(dict, type, result);
+    return gddApplicationTypeTable::app_table.smartCopy(&result, &metadata) == 0;
+}
 
-        case gddAppType_dbr_ctrl_enum:
-            return read_enum(dict, type, result);
-        case gddAppType_dbr_ctrl_char:
-            return read_ctrl(dict, type, result);
-        case gddAppType_dbr_ctrl_short:
-            return read_ctrl(dict, type, result);
-        case gddAppType_dbr_ctrl_long:
-            return read_ctrl(dict, type, result);
-        case gddAppType_dbr_ctrl_float:
-            return read_ctrl(dict, type, result);
-        case gddAppType_dbr_ctrl_double:
-            return read_ctrl(dict, type, result);
+bool copy_value(gdd const& value, gdd& result)
+{
+    gdd* dest = value_member(result);
+    if (not dest) return true;
+
+    if (gddApplicationTypeTable::app_table.smartCopy(dest, &value) != 0) return false;
+
+    dest->setStatSevr(value.getStat(), value.getSevr());
+    epicsTimeStamp timestamp;
+    value.getTimeStamp(&timestamp);
+    dest->setTimeStamp(&timestamp);
+    return true;
+}
+
+bool value_to_gdd(PyObject* value, aitEnum type, gdd& result)
+{
+    return read_value(value, type, result);
+}
+
+bool to_gdd_value(PyObject* dict, aitEnum type, gdd& result)
+{
+    if (not dict) return false;
+
+    gdd* dest = value_member(result);
+    if (not dest) return true;
+
+    Attributes const* attributes = as_attributes(dict);
+    if (attributes) {
+        return read_simple(attributes, type, *dest);
     }
+    return read_simple(dict, type, *dest);
+}
 
-    char* app_name = gddApplicationTypeTable::app_table.getName(app);
-    if (app_name) {
-        PyErr_Format(PyExc_RuntimeError, "Unhandled gdd application type: %s", app_name);
-    } else {
-        PyErr_SetString(PyExc_RuntimeError, "Unhandled gdd application type");
+bool to_gdd(PyObject* dict, aitEnum type, gdd &result)
+{
+    if (not dict) return false;
+
+    Attributes const* attributes = as_attributes(dict);
+    if (attributes) {
+        return read_attributes(attributes, type, result);
     }
-    return false;
+    return read_attributes(dict, type, result);
 }
 
-PyObject* from_gdd(gdd const& value, bool numpy)
+PyObject* from_gdd(gdd const& value, bool numpy, bool numpy_view)
 {
     int app = value.applicationType();
     if (app != gddAppType_value) {
@@ -664,22 +1165,22 @@ PyObject* from_gdd(gdd const& value, bool numpy)
             val = write_string(value);
             break;
         case aitEnumEnum16:
-            val = write_value<aitEnum16>(value, numpy);
+            val = write_value<aitEnum16>(value, numpy, numpy_view);
             break;
         case aitEnumInt8:
-            val = write_value<aitInt8>(value, numpy);
+            val = write_value<aitInt8>(value, numpy, numpy_view);
             break;
         case aitEnumInt16:
-            val = write_value<aitInt16>(value, numpy);
+            val = write_value<aitInt16>(value, numpy, numpy_view);
             break;
         case aitEnumInt32:
-            val = write_value<aitInt32>(value, numpy);
+            val = write_value<aitInt32>(value, numpy, numpy_view);
             break;
         case aitEnumFloat32:
-            val = write_value<aitFloat32>(value, numpy);
+            val = write_value<aitFloat32>(value, numpy, numpy_view);
             break;
         case aitEnumFloat64:
-            val = write_value<aitFloat64>(value, numpy);
+            val = write_value<aitFloat64>(value, numpy, numpy_view);
             break;
         default:
             PyErr_SetString(PyExc_RuntimeError, "Unhandled gdd primitive type");
@@ -693,28 +1194,19 @@ bool to_event_mask(PyObject* value, casEventMask& mask, caServer const& server)
 {
     if (not value) return false;
 
-    PyObject* py_val = PyObject_GetAttrString(value, "value");
-    if (not py_val) return false;
+    unsigned long flag_value;
+    if (PyLong_Check(value)) {
+        flag_value = PyLong_AsUnsignedLong(value);
+    } else {
+        PyObject* py_val = PyObject_GetAttrString(value, "value");
+        if (not py_val) return false;
 
-    int flag_value = PyLong_AsUnsignedLong(py_val);
-    Py_DECREF(py_val);
+        flag_value = PyLong_AsUnsignedLong(py_val);
+        Py_DECREF(py_val);
+    }
     if (PyErr_Occurred()) return false;
 
-    Py_BEGIN_ALLOW_THREADS
-      if (flag_value & DBE_VALUE) {
-          mask |= server.valueEventMask();
-      }
-      if (flag_value & DBE_ARCHIVE) {
-          mask |= server.logEventMask();
-      }
-      if (flag_value & DBE_ALARM) {
-          mask |= server.alarmEventMask();
-      }
-      if (flag_value & DBE_PROPERTY) {
-          mask |= server.propertyEventMask();
-      }
-    Py_END_ALLOW_THREADS
-
+    mask |= event_mask(server, flag_value);
     return true;
 }
 
@@ -7,7 +7,23 @@
 
 namespace cas {
 
-/** Convert ExistsResponse enum value to pvExistsReturn value
+/** Drop a reference to ``obj`` later, when the GIL is held.
+ * Does not need the GIL.
+ */
+void defer_decref(PyObject* obj);
+
+/** Drop the references given to ``defer_decref()``.
+ * GIL must be held.
+ */
+void release_deferred_references();
+
+/** Return ``true`` if ``defer_decref()`` was called since the last
+ * ``release_deferred_references()``. Does not need the GIL.
+ */
+bool has_deferred_decrefs();
+
+/** Convert an ExistsResponse enum value, a bool or an ``(ip, port)``
+ * tuple to a pvExistsReturn value. Raises TypeError for other values.
  */
 bool to_exist_return(PyObject* value, pvExistReturn& result);
 
@@ -25,12 +41,41 @@ bool to_ait_enum(PyObject* value, aitEnum& result);
  */
 bool to_gdd(PyObject* dict, aitEnum type, gdd &result);
 
+/** create a gdd which holds all attributes of a PV with the given type
+ * This is a ctrl container for numerical and enum types and a value
+ * for strings. Fill it with to_gdd().
+ * Returns a new gdd, nullptr with an exception set on errors.
+ */
+gdd* create_attributes_gdd(aitEnum type);
+
+/** copy the meta data from a gdd created by create_attributes_gdd()
+ * into a request prototype. Does not need the GIL.
+ */
+bool copy_metadata(gdd const& metadata, gdd& result);
+
+/** copy value, status, severity and timestamp into a request prototype
+ * Does not need the GIL.
+ */
+bool copy_value(gdd const& value, gdd& result);
+
+/** convert a single value (number, sequence or bytes) into result.
+ * Status, severity and timestamp are not changed.
+ */
+bool value_to_gdd(PyObject* value, aitEnum type, gdd& result);
+
+/** convert only value, status, severity and timestamp of an attributes
+ * dictionary. The meta data in result is not changed.
+ */
+bool to_gdd_value(PyObject* dict, aitEnum type, gdd& result);
+
 /** convert a gdd value to a python value
  * If compiled without numpy support, numpy is always false.
  * For array values:
  *   if numpy is true create a numpy array otherwise create a tuple.
+ *   if numpy_view is true too, the numpy array is a read-only view of
+ *   the gdd data which keeps the gdd referenced.
  */
-PyObject* from_gdd(gdd const& value, bool numpy = false);
+PyObject* from_gdd(gdd const& value, bool numpy = false, bool numpy_view = false);
 
 /** convert python Trigger value to caEvent mask value
  */
@@ -0,0 +1,187 @@
+#include "event_queue.hpp"
+
+#include <mutex>
+#include <gdd.h>
+
+#include "pv.hpp"
+#include "server_thread.hpp"
+
+namespace cas {
+namespace {
+
+std::size_t round_up_to_power_of_two(std::size_t value)
+{
+    std::size_t result = 1;
+    while (result < value) result <<= 1;
+    return result;
+}
+
+// Created once and never destroyed, producers may still hold the pointer
+std::atomic<EventQueue*> global_queue{nullptr};
+std::mutex configure_mutex;
+// Serializes consumers, process() and PVs which are deallocated
+std::mutex consumer_mutex;
+
+thread_local bool in_process = false;
+
+}
+
+EventQueue::EventQueue(std::size_t capacity)
+    : slots{new Slot[round_up_to_power_of_two(capacity)]},
+      mask{round_up_to_power_of_two(capacity) - 1},
+      enqueue_position{0}, dequeue_position{0}, high_water{0},
+      is_enabled{false}, overflow_count{0}, posted_count{0}
+{
+    for (std::size_t i = 0; i <= mask; ++i) {
+        slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+bool EventQueue::push(casPV& pv, casEventMask const& event_mask, gdd& values)
+{
+    Slot* slot;
+    std::size_t position = enqueue_position.load(std::memory_order_relaxed);
+    for (;;) {
+        slot = &slots[position & mask];
+        std::size_t const sequence = slot->sequence.load(std::memory_order_acquire);
+        auto const difference = static_cast<std::ptrdiff_t>(sequence - position);
+        if (difference == 0) {
+            if (enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+        } else if (difference < 0) {
+            overflow_count.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            position = enqueue_position.load(std::memory_order_relaxed);
+        }
+    }
+
+    values.reference();
+    slot->event.pv = &pv;
+    slot->event.mask = event_mask;
+    slot->event.values = &values;
+    slot->sequence.store(position + 1, std::memory_order_release);
+
+    // The consumer may already have passed this slot
+    std::size_t const dequeued = dequeue_position.load(std::memory_order_relaxed);
+    std::size_t const current = position + 1 > dequeued ? position + 1 - dequeued : 0;
+    std::size_t highest = high_water.load(std::memory_order_relaxed);
+    while (current > highest and not high_water.compare_exchange_weak(highest, current, std::memory_order_relaxed)) {}
+    return true;
+}
+
+bool EventQueue::pop(Event& event)
+{
+    std::size_t const position = dequeue_position.load(std::memory_order_relaxed);
+    Slot& slot = slots[position & mask];
+    if (slot.sequence.load(std::memory_order_acquire) != position + 1) return false;
+
+    event = slot.event;
+    slot.sequence.store(position + mask + 1, std::memory_order_release);
+    dequeue_position.store(position + 1, std::memory_order_relaxed);
+    posted_count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void EventQueue::setEnabled(bool enabled)
+{
+    is_enabled.store(enabled);
+}
+
+bool EventQueue::enabled() const
+{
+    return is_enabled.load(std::memory_order_relaxed);
+}
+
+std::size_t EventQueue::capacity() const
+{
+    return mask + 1;
+}
+
+std::size_t EventQueue::depth() const
+{
+    std::size_t const dequeued = dequeue_position.load(std::memory_order_relaxed);
+    std::size_t const enqueued = enqueue_position.load(std::memory_order_relaxed);
+    // Both are read separately, a concurrent pop can overtake
+    return enqueued > dequeued ? enqueued - dequeued : 0;
+}
+
+std::size_t EventQueue::highWater() const
+{
+    return high_water.load(std::memory_order_relaxed);
+}
+
+std::uint64_t EventQueue::overflows() const
+{
+    return overflow_count.load(std::memory_order_relaxed);
+}
+
+std::uint64_t EventQueue::posted() const
+{
+    return posted_count.load(std::memory_order_relaxed);
+}
+
+
+bool configure_event_queue(std::size_t capacity)
+{
+    std::lock_guard<std::mutex> lock(configure_mutex);
+    EventQueue* queue = global_queue.load();
+    if (capacity == 0) {
+        if (queue) {
+            queue->setEnabled(false);
+            // Events are posted directly from now on, the queued
+            // ones have to be posted before them
+            drain_event_queue();
+        }
+        return true;
+    }
+
+    if (not queue) {
+        queue = new EventQueue{capacity};
+        global_queue.store(queue);
+    } else if (queue->capacity() != round_up_to_power_of_two(capacity)) {
+        return false;
+    }
+    queue->setEnabled(true);
+    return true;
+}
+
+EventQueue const* event_queue()
+{
+    return global_queue.load();
+}
+
+bool enqueue_event(casPV& pv, casEventMask const& mask, gdd& values)
+{
+    if (in_process) return false;
+    EventQueue* queue = global_queue.load(std::memory_order_acquire);
+    if (not queue or not queue->enabled()) return false;
+    if (not queue->push(pv, mask, values)) return false;
+
+    wake_process_thread();
+    return true;
+}
+
+void drain_event_queue()
+{
+    EventQueue* queue = global_queue.load(std::memory_order_acquire);
+    if (not queue) return;
+
+    std::lock_guard<std::mutex> lock(consumer_mutex);
+    EventQueue::Event event;
+    while (queue->pop(event)) {
+        post_queued_event(*event.pv, event.mask, *event.values);
+        event.values->unreference();
+    }
+}
+
+ProcessScope::ProcessScope()
+{
+    in_process = true;
+}
+
+ProcessScope::~ProcessScope()
+{
+    in_process = false;
+}
+
+}
@@ -0,0 +1,121 @@
+#ifndef INCLUDE_GUARD_D25A7C40_81E6_4F93_A3B7_0E6C59F18B2D
+#define INCLUDE_GUARD_D25A7C40_81E6_4F93_A3B7_0E6C59F18B2D
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <casdef.h>
+
+class gdd;
+
+namespace cas {
+
+/** Bounded multi-producer/single-consumer queue of events.
+ *
+ * A ring buffer with a sequence number per slot: producers claim a slot
+ * with a compare-and-swap and never block, the consumer needs no atomic
+ * read-modify-write at all. Only one thread may pop at a time.
+ *
+ * Does not need the GIL.
+ */
+class EventQueue {
+public:
+    struct Event {
+        casPV* pv;
+        casEventMask mask;
+        gdd* values;
+    };
+
+    /** ``capacity`` is rounded up to a power of two.
+     */
+    explicit EventQueue(std::size_t capacity);
+
+    EventQueue(EventQueue const&) = delete;
+    EventQueue& operator=(EventQueue const&) = delete;
+
+    /** Enqueue an event, ``values`` is referenced.
+     * Returns ``false`` if the queue is full.
+     */
+    bool push(casPV& pv, casEventMask const& mask, gdd& values);
+
+    /** Dequeue the oldest event, the caller owns the reference of
+     * ``event.values``. Returns ``false`` if the queue is empty.
+     */
+    bool pop(Event& event);
+
+    /** Producers only push while the queue is enabled.
+     */
+    void setEnabled(bool enabled);
+    bool enabled() const;
+
+    std::size_t capacity() const;
+    std::size_t depth() const;
+    std::size_t highWater() const;
+    std::uint64_t overflows() const;
+    std::uint64_t posted() const;
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        Event event;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::size_t const mask;
+
+    // Producers and consumer on different cache lines. Padding instead
+    // of alignas, over-aligned new needs C++17.
+    static constexpr std::size_t cache_line = 64;
+    char padding_producer[cache_line];
+    std::atomic<std::size_t> enqueue_position;
+    char padding_consumer[cache_line - sizeof(std::atomic<std::size_t>)];
+    std::atomic<std::size_t> dequeue_position;
+    char padding_statistics[cache_line - sizeof(std::atomic<std::size_t>)];
+    std::atomic<std::size_t> high_water;
+    std::atomic<bool> is_enabled;
+    std::atomic<std::uint64_t> overflow_count;
+    std::atomic<std::uint64_t> posted_count;
+};
+
+/** Enable the global event queue with ``capacity`` slots or disable
+ * it with ``0``. Disabling posts the queued events.
+ *
+ * The queue is created once, returns ``false`` if a different capacity
+ * is requested later. Does not need the GIL.
+ */
+bool configure_event_queue(std::size_t capacity);
+
+/** Return the global event queue or ``nullptr`` if it was never enabled.
+ */
+EventQueue const* event_queue();
+
+/** Enqueue an event for the thread running ``process()``.
+ *
+ * Returns ``false`` if the queue is disabled or full or if it is called
+ * from the thread running ``process()``, the caller posts the event
+ * itself then. To keep the order it has to call ``drain_event_queue()``
+ * first if older events of the same PV are still queued. Does not need
+ * the GIL.
+ */
+bool enqueue_event(casPV& pv, casEventMask const& mask, gdd& values);
+
+/** Post all queued events. Does not need the GIL.
+ */
+void drain_event_queue();
+
+/** Marks the current thread as the one running ``process()`` for
+ * the lifetime of the object.
+ */
+class ProcessScope {
+public:
+    ProcessScope();
+    ~ProcessScope();
+
+    ProcessScope(ProcessScope const&) = delete;
+    ProcessScope& operator=(ProcessScope const&) = delete;
+};
+
+}
+
+#endif
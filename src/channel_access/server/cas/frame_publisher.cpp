@@ -0,0 +1,173 @@
+#include "frame_publisher.hpp"
+
+#include <utility>
+#include <fdManager.h>
+
+#include "server_thread.hpp"
+
+namespace cas {
+
+FramePublisher::FramePublisher(PyObject* target)
+    : target(target), timer(fileDescriptorManager.createTimer()),
+      interval{0.0}, timer_started{false}, closed{false}, frame_count{0}
+{
+}
+
+FramePublisher::~FramePublisher()
+{
+    // Waits for a running expire(), clear() already released the PVs
+    timer.destroy();
+}
+
+void FramePublisher::setRate(double rate)
+{
+    std::vector<PyObject*> pvs;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        interval = rate > 0.0 ? 1.0 / rate : 0.0;
+        if (interval == 0.0) {
+            pvs.swap(dirty);
+            dirty_set.clear();
+        }
+    }
+
+    if (not pvs.empty()) {
+        // expire() needs the GIL, don't wait for it with the GIL held
+        Py_BEGIN_ALLOW_THREADS
+            timer.cancel();
+        Py_END_ALLOW_THREADS
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            timer_started = false;
+        }
+        publish(pvs);
+    }
+}
+
+double FramePublisher::rate() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return interval > 0.0 ? 1.0 / interval : 0.0;
+}
+
+bool FramePublisher::markDirty(PyObject* pv)
+{
+    bool start_timer = false;
+    double delay = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (interval == 0.0 or closed) return false;
+
+        if (dirty_set.insert(pv).second) {
+            Py_INCREF(pv);
+            dirty.push_back(pv);
+        }
+        if (not timer_started) {
+            timer_started = true;
+            start_timer = true;
+            if (frame_count > 0) {
+                delay = interval - (epicsTime::getCurrent() - last_frame);
+                if (delay < 0.0) delay = 0.0;
+            }
+        }
+    }
+
+    if (start_timer) {
+        timer.start(*this, delay);
+        // The loop only recalculates its timeout when it wakes up
+        wake_process_thread();
+    }
+    return true;
+}
+
+std::uint64_t FramePublisher::frames() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return frame_count;
+}
+
+int FramePublisher::traverse(visitproc visit, void* arg)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (PyObject* pv : dirty) {
+        Py_VISIT(pv);
+    }
+    return 0;
+}
+
+void FramePublisher::clear()
+{
+    std::vector<PyObject*> pvs;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        pvs.swap(dirty);
+        dirty_set.clear();
+    }
+    for (PyObject* pv : pvs) {
+        Py_DECREF(pv);
+    }
+}
+
+epicsTimerNotify::expireStatus FramePublisher::expire(epicsTime const& current_time)
+{
+    std::vector<PyObject*> pvs;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pvs.swap(dirty);
+        dirty_set.clear();
+        timer_started = false;
+        last_frame = current_time;
+    }
+    if (pvs.empty()) return noRestart;
+
+    PyGILState_STATE gstate = PyGILState_Ensure();
+        bool is_closed;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            is_closed = closed;
+        }
+        if (is_closed) {
+            // The target is going away, drop the frame
+            for (PyObject* pv : pvs) {
+                Py_DECREF(pv);
+            }
+        } else {
+            publish(pvs);
+        }
+    PyGILState_Release(gstate);
+    return noRestart;
+}
+
+void FramePublisher::publish(std::vector<PyObject*>& pvs)
+{
+    PyObject* list = PyList_New(pvs.size());
+    if (list) {
+        for (std::size_t i = 0; i < pvs.size(); ++i) {
+            // Steals the reference
+            PyList_SET_ITEM(list, i, pvs[i]);
+        }
+    } else {
+        for (PyObject* pv : pvs) {
+            Py_DECREF(pv);
+        }
+    }
+    pvs.clear();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        ++frame_count;
+    }
+
+    if (list) {
+        PyObject* result = PyObject_CallMethod(target, "publishFrame", "O", list);
+        Py_XDECREF(result);
+        Py_DECREF(list);
+    }
+    if (PyErr_Occurred()) {
+        PyErr_WriteUnraisable(target);
+        PyErr_Clear();
+    }
+}
+
+}
@@ -0,0 +1,76 @@
+#ifndef INCLUDE_GUARD_9B3F6E21_4D7C_4A58_B0E2_5C18A7D94F36
+#define INCLUDE_GUARD_9B3F6E21_4D7C_4A58_B0E2_5C18A7D94F36
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include <Python.h>
+#include <epicsTimer.h>
+
+namespace cas {
+
+/** Collects dirty PVs and publishes them once per frame.
+ *
+ * PVs marked dirty are kept in insertion order, every PV at most once.
+ * A timer of the fdManager loop, i.e. ``cas.process()``, hands all dirty
+ * PVs of a frame to the ``publishFrame()`` method of the target object
+ * in a single call.
+ */
+class FramePublisher : public epicsTimerNotify {
+public:
+    /** ``target`` is a borrowed reference which must outlive this object.
+     */
+    explicit FramePublisher(PyObject* target);
+    ~FramePublisher();
+
+    FramePublisher(FramePublisher const&) = delete;
+    FramePublisher& operator=(FramePublisher const&) = delete;
+
+    /** Set the number of frames per second. ``0`` disables frames,
+     * already dirty PVs are published immediately. Needs the GIL.
+     */
+    void setRate(double rate);
+
+    /** Return the number of frames per second, ``0`` if disabled.
+     * Does not need the GIL.
+     */
+    double rate() const;
+
+    /** Mark ``pv`` dirty. Returns ``false`` if frames are disabled.
+     * Needs the GIL.
+     */
+    bool markDirty(PyObject* pv);
+
+    /** Return the number of published frames. Does not need the GIL.
+     */
+    std::uint64_t frames() const;
+
+    // Python GC support, need the GIL
+    int traverse(visitproc visit, void* arg);
+    void clear();
+
+private:
+    expireStatus expire(epicsTime const& current_time) override;
+
+    // Call publishFrame() and release the references. Needs the GIL.
+    void publish(std::vector<PyObject*>& pvs);
+
+    PyObject* target;
+    epicsTimer& timer;
+
+    mutable std::mutex mutex;
+    // Time between two frames in seconds, 0 if disabled
+    double interval;
+    epicsTime last_frame;
+    bool timer_started;
+    bool closed;
+    std::uint64_t frame_count;
+    // Strong references in the order the PVs were marked
+    std::vector<PyObject*> dirty;
+    std::unordered_set<PyObject*> dirty_set;
+};
+
+}
+
+#endif
@@ -0,0 +1,657 @@
+#include "kernels.hpp"
+
+#if defined(__SSE2__)
+#  include <immintrin.h>
+#  define CAS_KERNELS_X86 1
+#else
+#  define CAS_KERNELS_X86 0
+#endif
+
+namespace cas {
+namespace {
+
+#if CAS_KERNELS_X86
+
+bool has_avx2()
+{
+    static bool const result = __builtin_cpu_supports("avx2");
+    return result;
+}
+
+// The vector conversions use the current rounding mode and return the
+// "integer indefinite" value for out of range floats, like the scalar ones.
+
+void double_to_float_sse2(double const* source, float* destination, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 const low = _mm_cvtpd_ps(_mm_loadu_pd(source + i));
+        __m128 const high = _mm_cvtpd_ps(_mm_loadu_pd(source + i + 2));
+        _mm_storeu_ps(destination + i, _mm_movelh_ps(low, high));
+    }
+    convert_elements<double, float>(source + i, destination + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void double_to_float_avx2(double const* source, float* destination, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128 const low = _mm256_cvtpd_ps(_mm256_loadu_pd(source + i));
+        __m128 const high = _mm256_cvtpd_ps(_mm256_loadu_pd(source + i + 4));
+        _mm256_storeu_ps(destination + i, _mm256_set_m128(high, low));
+    }
+    convert_elements<double, float>(source + i, destination + i, count - i);
+}
+
+void float_to_double_sse2(float const* source, double* destination, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 const values = _mm_loadu_ps(source + i);
+        _mm_storeu_pd(destination + i, _mm_cvtps_pd(values));
+        _mm_storeu_pd(destination + i + 2, _mm_cvtps_pd(_mm_movehl_ps(values, values)));
+    }
+    convert_elements<float, double>(source + i, destination + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void float_to_double_avx2(float const* source, double* destination, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_pd(destination + i, _mm256_cvtps_pd(_mm_loadu_ps(source + i)));
+        _mm256_storeu_pd(destination + i + 4, _mm256_cvtps_pd(_mm_loadu_ps(source + i + 4)));
+    }
+    convert_elements<float, double>(source + i, destination + i, count - i);
+}
+
+void double_to_int32_sse2(double const* source, std::int32_t* destination, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i const low = _mm_cvttpd_epi32(_mm_loadu_pd(source + i));
+        __m128i const high = _mm_cvttpd_epi32(_mm_loadu_pd(source + i + 2));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_unpacklo_epi64(low, high));
+    }
+    convert_elements<double, std::int32_t>(source + i, destination + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void double_to_int32_avx2(double const* source, std::int32_t* destination, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i const low = _mm256_cvttpd_epi32(_mm256_loadu_pd(source + i));
+        __m128i const high = _mm256_cvttpd_epi32(_mm256_loadu_pd(source + i + 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination + i), _mm256_set_m128i(high, low));
+    }
+    convert_elements<double, std::int32_t>(source + i, destination + i, count - i);
+}
+
+void int32_to_double_sse2(std::int32_t const* source, double* destination, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i const values = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + i));
+        _mm_storeu_pd(destination + i, _mm_cvtepi32_pd(values));
+        _mm_storeu_pd(destination + i + 2, _mm_cvtepi32_pd(_mm_unpackhi_epi64(values, values)));
+    }
+    convert_elements<std::int32_t, double>(source + i, destination + i, count - i);
+}
+
+__attribute__((target("avx2")))
+void int32_to_double_avx2(std::int32_t const* source, double* destination, std::size_t count)
+{
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i const low = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + i));
+        __m128i const high = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + i + 4));
+        _mm256_storeu_pd(destination + i, _mm256_cvtepi32_pd(low));
+        _mm256_storeu_pd(destination + i + 4, _mm256_cvtepi32_pd(high));
+    }
+    convert_elements<std::int32_t, double>(source + i, destination + i, count - i);
+}
+
+// Keeps the low half of every element, i.e. wraps around like the scalar cast.
+// Return the number of converted elements, the caller converts the rest.
+std::size_t int64_to_int32_sse2(void const* source, std::int32_t* destination, std::size_t count)
+{
+    auto const* input = static_cast<char const*>(source);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 const low = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<__m128i const*>(input + 8 * i)));
+        __m128 const high = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<__m128i const*>(input + 8 * i + 16)));
+        __m128 const result = _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm_castps_si128(result));
+    }
+    return i;
+}
+
+__attribute__((target("avx2")))
+std::size_t int64_to_int32_avx2(void const* source, std::int32_t* destination, std::size_t count)
+{
+    auto const* input = static_cast<char const*>(source);
+    __m256i const order = _mm256_setr_epi32(0, 2, 4, 6, 1, 3, 5, 7);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i const values = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(input + 8 * i));
+        __m256i const result = _mm256_permutevar8x32_epi32(values, order);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + i), _mm256_castsi256_si128(result));
+    }
+    return i;
+}
+
+// The minimum and maximum instructions return the second operand if one
+// is NaN, the accumulator is always the second one so NaNs are ignored.
+
+void minmax_double_sse2(double const* data, std::size_t count, double& lowest, double& highest)
+{
+    __m128d low = _mm_set1_pd(lowest);
+    __m128d high = _mm_set1_pd(highest);
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d const values = _mm_loadu_pd(data + i);
+        low = _mm_min_pd(values, low);
+        high = _mm_max_pd(values, high);
+    }
+    double lows[2], highs[2];
+    _mm_storeu_pd(lows, low);
+    _mm_storeu_pd(highs, high);
+    minmax_elements<double>(data + i, count - i, lowest, highest);
+    for (unsigned j = 0; j < 2; ++j) {
+        if (lows[j] < lowest) lowest = lows[j];
+        if (highs[j] > highest) highest = highs[j];
+    }
+}
+
+__attribute__((target("avx2")))
+void minmax_double_avx2(double const* data, std::size_t count, double& lowest, double& highest)
+{
+    __m256d low = _mm256_set1_pd(lowest);
+    __m256d high = _mm256_set1_pd(highest);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d const values = _mm256_loadu_pd(data + i);
+        low = _mm256_min_pd(values, low);
+        high = _mm256_max_pd(values, high);
+    }
+    double lows[4], highs[4];
+    _mm256_storeu_pd(lows, low);
+    _mm256_storeu_pd(highs, high);
+    minmax_elements<double>(data + i, count - i, lowest, highest);
+    for (unsigned j = 0; j < 4; ++j) {
+        if (lows[j] < lowest) lowest = lows[j];
+        if (highs[j] > highest) highest = highs[j];
+    }
+}
+
+void minmax_float_sse2(float const* data, std::size_t count, float& lowest, float& highest)
+{
+    __m128 low = _mm_set1_ps(lowest);
+    __m128 high = _mm_set1_ps(highest);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 const values = _mm_loadu_ps(data + i);
+        low = _mm_min_ps(values, low);
+        high = _mm_max_ps(values, high);
+    }
+    float lows[4], highs[4];
+    _mm_storeu_ps(lows, low);
+    _mm_storeu_ps(highs, high);
+    minmax_elements<float>(data + i, count - i, lowest, highest);
+    for (unsigned j = 0; j < 4; ++j) {
+        if (lows[j] < lowest) lowest = lows[j];
+        if (highs[j] > highest) highest = highs[j];
+    }
+}
+
+__attribute__((target("avx2")))
+void minmax_float_avx2(float const* data, std::size_t count, float& lowest, float& highest)
+{
+    __m256 low = _mm256_set1_ps(lowest);
+    __m256 high = _mm256_set1_ps(highest);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 const values = _mm256_loadu_ps(data + i);
+        low = _mm256_min_ps(values, low);
+        high = _mm256_max_ps(values, high);
+    }
+    float lows[8], highs[8];
+    _mm256_storeu_ps(lows, low);
+    _mm256_storeu_ps(highs, high);
+    minmax_elements<float>(data + i, count - i, lowest, highest);
+    for (unsigned j = 0; j < 8; ++j) {
+        if (lows[j] < lowest) lowest = lows[j];
+        if (highs[j] > highest) highest = highs[j];
+    }
+}
+
+__attribute__((target("avx2")))
+void minmax_int32_avx2(std::int32_t const* data, std::size_t count, std::int32_t& lowest, std::int32_t& highest)
+{
+    __m256i low = _mm256_set1_epi32(lowest);
+    __m256i high = _mm256_set1_epi32(highest);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i const values = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i));
+        low = _mm256_min_epi32(values, low);
+        high = _mm256_max_epi32(values, high);
+    }
+    std::int32_t lows[8], highs[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lows), low);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(highs), high);
+    minmax_elements<std::int32_t>(data + i, count - i, lowest, highest);
+    for (unsigned j = 0; j < 8; ++j) {
+        if (lows[j] < lowest) lowest = lows[j];
+        if (highs[j] > highest) highest = highs[j];
+    }
+}
+
+// NaN values are the second operand of the minimum, so they are kept
+void clamp_double_sse2(double* data, std::size_t count, double low, double high)
+{
+    __m128d const lows = _mm_set1_pd(low);
+    __m128d const highs = _mm_set1_pd(high);
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d const values = _mm_loadu_pd(data + i);
+        _mm_storeu_pd(data + i, _mm_max_pd(lows, _mm_min_pd(highs, values)));
+    }
+    clamp_elements<double>(data + i, count - i, low, high);
+}
+
+__attribute__((target("avx2")))
+void clamp_double_avx2(double* data, std::size_t count, double low, double high)
+{
+    __m256d const lows = _mm256_set1_pd(low);
+    __m256d const highs = _mm256_set1_pd(high);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d const values = _mm256_loadu_pd(data + i);
+        _mm256_storeu_pd(data + i, _mm256_max_pd(lows, _mm256_min_pd(highs, values)));
+    }
+    clamp_elements<double>(data + i, count - i, low, high);
+}
+
+void clamp_float_sse2(float* data, std::size_t count, float low, float high)
+{
+    __m128 const lows = _mm_set1_ps(low);
+    __m128 const highs = _mm_set1_ps(high);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 const values = _mm_loadu_ps(data + i);
+        _mm_storeu_ps(data + i, _mm_max_ps(lows, _mm_min_ps(highs, values)));
+    }
+    clamp_elements<float>(data + i, count - i, low, high);
+}
+
+__attribute__((target("avx2")))
+void clamp_float_avx2(float* data, std::size_t count, float low, float high)
+{
+    __m256 const lows = _mm256_set1_ps(low);
+    __m256 const highs = _mm256_set1_ps(high);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 const values = _mm256_loadu_ps(data + i);
+        _mm256_storeu_ps(data + i, _mm256_max_ps(lows, _mm256_min_ps(highs, values)));
+    }
+    clamp_elements<float>(data + i, count - i, low, high);
+}
+
+__attribute__((target("avx2")))
+void clamp_int32_avx2(std::int32_t* data, std::size_t count, std::int32_t low, std::int32_t high)
+{
+    __m256i const lows = _mm256_set1_epi32(low);
+    __m256i const highs = _mm256_set1_epi32(high);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i const values = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(data + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_max_epi32(lows, _mm256_min_epi32(highs, values)));
+    }
+    clamp_elements<std::int32_t>(data + i, count - i, low, high);
+}
+
+// One step of compare_elements(), see there for the rules
+struct CompareSse2 {
+    __m128d relative_tolerance;
+    __m128d absolute_tolerance;
+    __m128d changed;
+    __m128d difference;
+
+    CompareSse2(double relative, double absolute)
+        : relative_tolerance{_mm_set1_pd(relative)},
+          absolute_tolerance{_mm_set1_pd(absolute)},
+          changed{_mm_setzero_pd()},
+          difference{_mm_setzero_pd()}
+    {}
+
+    void step(__m128d value, __m128d old_value)
+    {
+        __m128d const sign = _mm_set1_pd(-0.0);
+        __m128d const infinity = _mm_set1_pd(std::numeric_limits<double>::infinity());
+
+        __m128d const equal = _mm_or_pd(_mm_cmpeq_pd(value, old_value),
+            _mm_and_pd(_mm_cmpunord_pd(value, value), _mm_cmpunord_pd(old_value, old_value)));
+        __m128d diff = _mm_andnot_pd(sign, _mm_sub_pd(value, old_value));
+        __m128d const nan = _mm_cmpunord_pd(diff, diff);
+        diff = _mm_or_pd(_mm_andnot_pd(nan, diff), _mm_and_pd(nan, infinity));
+        diff = _mm_andnot_pd(equal, diff);
+        difference = _mm_max_pd(diff, difference);
+
+        __m128d const abs_value = _mm_andnot_pd(sign, value);
+        __m128d const abs_old_value = _mm_andnot_pd(sign, old_value);
+        __m128d const finite = _mm_and_pd(_mm_cmplt_pd(abs_value, infinity), _mm_cmplt_pd(abs_old_value, infinity));
+        __m128d const within = _mm_or_pd(_mm_or_pd(
+            _mm_cmple_pd(diff, _mm_mul_pd(relative_tolerance, abs_value)),
+            _mm_cmple_pd(diff, _mm_mul_pd(relative_tolerance, abs_old_value))),
+            _mm_cmple_pd(diff, absolute_tolerance));
+        __m128d const close = _mm_or_pd(equal, _mm_and_pd(finite, within));
+        changed = _mm_or_pd(changed, _mm_andnot_pd(close, _mm_castsi128_pd(_mm_set1_epi32(-1))));
+    }
+
+    void finish(bool& any_changed, double& max_difference) const
+    {
+        double differences[2];
+        _mm_storeu_pd(differences, difference);
+        any_changed = any_changed or _mm_movemask_pd(changed) != 0;
+        for (double diff : differences) {
+            if (diff > max_difference) max_difference = diff;
+        }
+    }
+};
+
+struct CompareAvx2 {
+    __m256d relative_tolerance;
+    __m256d absolute_tolerance;
+    __m256d changed;
+    __m256d difference;
+
+    __attribute__((target("avx2")))
+    CompareAvx2(double relative, double absolute)
+        : relative_tolerance{_mm256_set1_pd(relative)},
+          absolute_tolerance{_mm256_set1_pd(absolute)},
+          changed{_mm256_setzero_pd()},
+          difference{_mm256_setzero_pd()}
+    {}
+
+    __attribute__((target("avx2")))
+    void step(__m256d value, __m256d old_value)
+    {
+        __m256d const sign = _mm256_set1_pd(-0.0);
+        __m256d const infinity = _mm256_set1_pd(std::numeric_limits<double>::infinity());
+
+        __m256d const equal = _mm256_or_pd(_mm256_cmp_pd(value, old_value, _CMP_EQ_OQ),
+            _mm256_and_pd(_mm256_cmp_pd(value, value, _CMP_UNORD_Q), _mm256_cmp_pd(old_value, old_value, _CMP_UNORD_Q)));
+        __m256d diff = _mm256_andnot_pd(sign, _mm256_sub_pd(value, old_value));
+        diff = _mm256_blendv_pd(diff, infinity, _mm256_cmp_pd(diff, diff, _CMP_UNORD_Q));
+        diff = _mm256_andnot_pd(equal, diff);
+        difference = _mm256_max_pd(diff, difference);
+
+        __m256d const abs_value = _mm256_andnot_pd(sign, value);
+        __m256d const abs_old_value = _mm256_andnot_pd(sign, old_value);
+        __m256d const finite = _mm256_and_pd(_mm256_cmp_pd(abs_value, infinity, _CMP_LT_OQ),
+            _mm256_cmp_pd(abs_old_value, infinity, _CMP_LT_OQ));
+        __m256d const within = _mm256_or_pd(_mm256_or_pd(
+            _mm256_cmp_pd(diff, _mm256_mul_pd(relative_tolerance, abs_value), _CMP_LE_OQ),
+            _mm256_cmp_pd(diff, _mm256_mul_pd(relative_tolerance, abs_old_value), _CMP_LE_OQ)),
+            _mm256_cmp_pd(diff, absolute_tolerance, _CMP_LE_OQ));
+        __m256d const close = _mm256_or_pd(equal, _mm256_and_pd(finite, within));
+        changed = _mm256_or_pd(changed, _mm256_andnot_pd(close, _mm256_castsi256_pd(_mm256_set1_epi32(-1))));
+    }
+
+    __attribute__((target("avx2")))
+    void finish(bool& any_changed, double& max_difference) const
+    {
+        double differences[4];
+        _mm256_storeu_pd(differences, difference);
+        any_changed = any_changed or _mm256_movemask_pd(changed) != 0;
+        for (double diff : differences) {
+            if (diff > max_difference) max_difference = diff;
+        }
+    }
+};
+
+std::size_t compare_double_sse2(double const* values, double const* old_values, std::size_t count,
+                                double relative_tolerance, double absolute_tolerance, bool& changed, double& difference)
+{
+    CompareSse2 compare{relative_tolerance, absolute_tolerance};
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        compare.step(_mm_loadu_pd(values + i), _mm_loadu_pd(old_values + i));
+    }
+    compare.finish(changed, difference);
+    return i;
+}
+
+__attribute__((target("avx2")))
+std::size_t compare_double_avx2(double const* values, double const* old_values, std::size_t count,
+                                double relative_tolerance, double absolute_tolerance, bool& changed, double& difference)
+{
+    CompareAvx2 compare{relative_tolerance, absolute_tolerance};
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        compare.step(_mm256_loadu_pd(values + i), _mm256_loadu_pd(old_values + i));
+    }
+    compare.finish(changed, difference);
+    return i;
+}
+
+std::size_t compare_float_sse2(float const* values, float const* old_values, std::size_t count,
+                               double relative_tolerance, double absolute_tolerance, bool& changed, double& difference)
+{
+    CompareSse2 compare{relative_tolerance, absolute_tolerance};
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 const value = _mm_loadu_ps(values + i);
+        __m128 const old_value = _mm_loadu_ps(old_values + i);
+        compare.step(_mm_cvtps_pd(value), _mm_cvtps_pd(old_value));
+        compare.step(_mm_cvtps_pd(_mm_movehl_ps(value, value)), _mm_cvtps_pd(_mm_movehl_ps(old_value, old_value)));
+    }
+    compare.finish(changed, difference);
+    return i;
+}
+
+__attribute__((target("avx2")))
+std::size_t compare_float_avx2(float const* values, float const* old_values, std::size_t count,
+                               double relative_tolerance, double absolute_tolerance, bool& changed, double& difference)
+{
+    CompareAvx2 compare{relative_tolerance, absolute_tolerance};
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        compare.step(_mm256_cvtps_pd(_mm_loadu_ps(values + i)), _mm256_cvtps_pd(_mm_loadu_ps(old_values + i)));
+    }
+    compare.finish(changed, difference);
+    return i;
+}
+
+#endif
+
+template <typename T>
+void int64_to_int32(T const* source, std::int32_t* destination, std::size_t count)
+{
+    std::size_t i = 0;
+#if CAS_KERNELS_X86
+    if (sizeof(T) == sizeof(std::int64_t)) {
+        i = has_avx2() ? int64_to_int32_avx2(source, destination, count)
+                       : int64_to_int32_sse2(source, destination, count);
+    }
+#endif
+    convert_elements<T, std::int32_t>(source + i, destination + i, count - i);
+}
+
+}
+
+void convert_elements(double const* source, float* destination, std::size_t count)
+{
+#if CAS_KERNELS_X86
+    if (has_avx2()) {
+        double_to_float_avx2(source, destination, count);
+    } else {
+        double_to_float_sse2(source, destination, count);
+    }
+#else
+    convert_elements<double, float>(source, destination, count);
+#endif
+}
+
+void convert_elements(float const* source, double* destination, std::size_t count)
+{
+#if CAS_KERNELS_X86
+    if (has_avx2()) {
+        float_to_double_avx2(source, destination, count);
+    } else {
+        float_to_double_sse2(source, destination, count);
+    }
+#else
+    convert_elements<float, double>(source, destination, count);
+#endif
+}
+
+void convert_elements(double const* source, std::int32_t* destination, std::size_t count)
+{
+#if CAS_KERNELS_X86
+    if (has_avx2()) {
+        double_to_int32_avx2(source, destination, count);
+    } else {
+        double_to_int32_sse2(source, destination, count);
+    }
+#else
+    convert_elements<double, std::int32_t>(source, destination, count);
+#endif
+}
+
+void convert_elements(std::int32_t const* source, double* destination, std::size_t count)
+{
+#if CAS_KERNELS_X86
+    if (has_avx2()) {
+        int32_to_double_avx2(source, destination, count);
+    } else {
+        int32_to_double_sse2(source, destination, count);
+    }
+#else
+    convert_elements<std::int32_t, double>(source, destination, count);
+#endif
+}
+
+void convert_elements(long const* source, std::int32_t* destination, std::size_t count)
+{
+    int64_to_int32(source, destination, count);
+}
+
+void convert_elements(long long const* source, std::int32_t* destination, std::size_t count)
+{
+    int64_to_int32(source, destination, count);
+}
+
+void minmax_elements(double const* data, std::size_t count, double& lowest, double& highest)
+{
+#if CAS_KERNELS_X86
+    lowest = std::numeric_limits<double>::infinity();
+    highest = -std::numeric_limits<double>::infinity();
+    if (has_avx2()) {
+        minmax_double_avx2(data, count, lowest, highest);
+    } else {
+        minmax_double_sse2(data, count, lowest, highest);
+    }
+#else
+    minmax_elements<double>(data, count, lowest, highest);
+#endif
+}
+
+void minmax_elements(float const* data, std::size_t count, float& lowest, float& highest)
+{
+#if CAS_KERNELS_X86
+    lowest = std::numeric_limits<float>::infinity();
+    highest = -std::numeric_limits<float>::infinity();
+    if (has_avx2()) {
+        minmax_float_avx2(data, count, lowest, highest);
+    } else {
+        minmax_float_sse2(data, count, lowest, highest);
+    }
+#else
+    minmax_elements<float>(data, count, lowest, highest);
+#endif
+}
+
+void minmax_elements(std::int32_t const* data, std::size_t count, std::int32_t& lowest, std::int32_t& highest)
+{
+#if CAS_KERNELS_X86
+    if (has_avx2()) {
+        lowest = std::numeric_limits<std::int32_t>::max();
+        highest = std::numeric_limits<std::int32_t>::lowest();
+        minmax_int32_avx2(data, count, lowest, highest);
+        return;
+    }
+#endif
+    minmax_elements<std::int32_t>(data, count, lowest, highest);
+}
+
+void clamp_elements(double* data, std::size_t count, double low, double high)
+{
+#if CAS_KERNELS_X86
+    if (has_avx2()) {
+        clamp_double_avx2(data, count, low, high);
+    } else {
+        clamp_double_sse2(data, count, low, high);
+    }
+#else
+    clamp_elements<double>(data, count, low, high);
+#endif
+}
+
+void clamp_elements(float* data, std::size_t count, float low, float high)
+{
+#if CAS_KERNELS_X86
+    if (has_avx2()) {
+        clamp_float_avx2(data, count, low, high);
+    } else {
+        clamp_float_sse2(data, count, low, high);
+    }
+#else
+    clamp_elements<float>(data, count, low, high);
+#endif
+}
+
+void clamp_elements(std::int32_t* data, std::size_t count, std::int32_t low, std::int32_t high)
+{
+#if CAS_KERNELS_X86
+    if (has_avx2()) {
+        clamp_int32_avx2(data, count, low, high);
+        return;
+    }
+#endif
+    clamp_elements<std::int32_t>(data, count, low, high);
+}
+
+void compare_elements(double const* values, double const* old_values, std::size_t count, double relative_tolerance, double absolute_tolerance,
+                      bool& changed, double& difference)
+{
+    std::size_t i = 0;
+    bool vector_changed = false;
+    double vector_difference = 0.0;
+#if CAS_KERNELS_X86
+    i = has_avx2() ? compare_double_avx2(values, old_values, count, relative_tolerance, absolute_tolerance, vector_changed, vector_difference)
+                   : compare_double_sse2(values, old_values, count, relative_tolerance, absolute_tolerance, vector_changed, vector_difference);
+#endif
+    compare_elements<double>(values + i, old_values + i, count - i, relative_tolerance, absolute_tolerance, changed, difference);
+    changed = changed or vector_changed;
+    if (vector_difference > difference) difference = vector_difference;
+}
+
+void compare_elements(float const* values, float const* old_values, std::size_t count, double relative_tolerance, double absolute_tolerance,
+                      bool& changed, double& difference)
+{
+    std::size_t i = 0;
+    bool vector_changed = false;
+    double vector_difference = 0.0;
+#if CAS_KERNELS_X86
+    i = has_avx2() ? compare_float_avx2(values, old_values, count, relative_tolerance, absolute_tolerance, vector_changed, vector_difference)
+                   : compare_float_sse2(values, old_values, count, relative_tolerance, absolute_tolerance, vector_changed, vector_difference);
+#endif
+    compare_elements<float>(values + i, old_values + i, count - i, relative_tolerance, absolute_tolerance, changed, difference);
+    changed = changed or vector_changed;
+    if (vector_difference > difference) difference = vector_difference;
+}
+
+}
@@ -0,0 +1,134 @@
+#ifndef INCLUDE_GUARD_6C0E3B8A_5F2D_4C1B_9A47_2E81D3F0B6C5
+#define INCLUDE_GUARD_6C0E3B8A_5F2D_4C1B_9A47_2E81D3F0B6C5
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace cas {
+
+/** Convert ``count`` elements from ``source`` to ``destination``.
+ *
+ * The result is the same as ``static_cast`` on every element, which is
+ * also what numpy's unsafe casts do: floats are rounded to nearest,
+ * floats to integers truncate and integers wrap around.
+ *
+ * The overloads below are vectorized on x86 (SSE2, AVX2 if the CPU
+ * supports it), all other combinations use this scalar loop.
+ * Does not need the GIL.
+ */
+template <typename From, typename To>
+void convert_elements(From const* source, To* destination, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        destination[i] = static_cast<To>(source[i]);
+    }
+}
+
+void convert_elements(double const* source, float* destination, std::size_t count);
+void convert_elements(float const* source, double* destination, std::size_t count);
+void convert_elements(double const* source, std::int32_t* destination, std::size_t count);
+void convert_elements(std::int32_t const* source, double* destination, std::size_t count);
+void convert_elements(long const* source, std::int32_t* destination, std::size_t count);
+void convert_elements(long long const* source, std::int32_t* destination, std::size_t count);
+
+/** Find the smallest and the largest of ``count`` elements.
+ *
+ * NaNs are ignored. If there are no other elements ``lowest`` is
+ * larger than ``highest`` afterwards.
+ *
+ * The overloads below are vectorized on x86, the int32 ones only with AVX2.
+ * Does not need the GIL.
+ */
+template <typename T>
+void minmax_elements(T const* data, std::size_t count, T& lowest, T& highest)
+{
+    lowest = std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+    highest = std::numeric_limits<T>::has_infinity ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::lowest();
+    for (std::size_t i = 0; i < count; ++i) {
+        if (data[i] < lowest) lowest = data[i];
+        if (data[i] > highest) highest = data[i];
+    }
+}
+
+void minmax_elements(double const* data, std::size_t count, double& lowest, double& highest);
+void minmax_elements(float const* data, std::size_t count, float& lowest, float& highest);
+void minmax_elements(std::int32_t const* data, std::size_t count, std::int32_t& lowest, std::int32_t& highest);
+
+/** Clamp ``count`` elements in place to ``[low, high]``.
+ *
+ * NaNs are kept. The overloads below are vectorized on x86, the int32
+ * one only with AVX2. Does not need the GIL.
+ */
+template <typename T>
+void clamp_elements(T* data, std::size_t count, T low, T high)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        T value = data[i];
+        value = high < value ? high : value;
+        value = low > value ? low : value;
+        data[i] = value;
+    }
+}
+
+void clamp_elements(double* data, std::size_t count, double low, double high);
+void clamp_elements(float* data, std::size_t count, float low, float high);
+void clamp_elements(std::int32_t* data, std::size_t count, std::int32_t low, std::int32_t high);
+
+/** Compare ``count`` elements of ``values`` with ``old_values`` in one pass.
+ *
+ * ``changed`` is set if any pair is not close like ``math.isclose()``
+ * with the given tolerances, integers are compared exactly.
+ * ``difference`` is the largest absolute difference. NaNs are equal to
+ * each other and infinitely different from all numbers.
+ *
+ * The overloads below are vectorized on x86. Does not need the GIL.
+ */
+template <typename T>
+auto compare_elements(T const* values, T const* old_values, std::size_t count, double, double,
+                      bool& changed, double& difference) -> typename std::enable_if<std::is_integral<T>::value>::type
+{
+    changed = false;
+    difference = 0.0;
+    for (std::size_t i = 0; i < count; ++i) {
+        if (values[i] != old_values[i]) {
+            double const diff = std::abs(static_cast<double>(values[i]) - static_cast<double>(old_values[i]));
+            if (diff > difference) difference = diff;
+            changed = true;
+        }
+    }
+}
+
+template <typename T>
+auto compare_elements(T const* values, T const* old_values, std::size_t count, double relative_tolerance, double absolute_tolerance,
+                      bool& changed, double& difference) -> typename std::enable_if<std::is_floating_point<T>::value>::type
+{
+    changed = false;
+    difference = 0.0;
+    for (std::size_t i = 0; i < count; ++i) {
+        double const value = values[i];
+        double const old_value = old_values[i];
+        if (value == old_value or (std::isnan(value) and std::isnan(old_value))) continue;
+
+        double diff = std::abs(value - old_value);
+        if (std::isnan(diff)) diff = std::numeric_limits<double>::infinity();
+        if (diff > difference) difference = diff;
+
+        bool const close = std::isfinite(value) and std::isfinite(old_value) and
+            (diff <= relative_tolerance * std::abs(value) or
+             diff <= relative_tolerance * std::abs(old_value) or
+             diff <= absolute_tolerance);
+        if (not close) changed = true;
+    }
+}
+
+void compare_elements(double const* values, double const* old_values, std::size_t count, double relative_tolerance, double absolute_tolerance,
+                      bool& changed, double& difference);
+void compare_elements(float const* values, float const* old_values, std::size_t count, double relative_tolerance, double absolute_tolerance,
+                      bool& changed, double& difference);
+
+}
+
+#endif
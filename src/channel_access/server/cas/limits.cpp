@@ -0,0 +1,426 @@
+#include "limits.hpp"
+
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+#include <alarm.h>
+#include <caeventmask.h>
+
+#if CA_SERVER_NUMPY_SUPPORT
+#define NO_IMPORT_ARRAY
+#include "numpy.hpp"
+#endif
+
+#include "kernels.hpp"
+
+namespace cas {
+namespace {
+
+// Arrays with at least this many elements are processed without the GIL
+constexpr std::size_t large_array_size = 1 << 16;
+
+template <typename Function>
+void run_large(std::size_t size, Function function)
+{
+    if (size < large_array_size) {
+        function();
+    } else {
+        Py_BEGIN_ALLOW_THREADS
+            function();
+        Py_END_ALLOW_THREADS
+    }
+}
+
+bool to_double(PyObject* obj, double& result)
+{
+    if (PyFloat_CheckExact(obj)) {
+        result = PyFloat_AS_DOUBLE(obj);
+        return true;
+    }
+    result = PyFloat_AsDouble(obj);
+    return not (result == -1.0 and PyErr_Occurred());
+}
+
+// Status and severity for a violation of one limits pair.
+// If both limits are violated (can happen in arrays) the violation with
+// the highest absolute difference is used.
+void check_limits(double lowest, double highest, Limits const& limits,
+                  int low_status, int high_status, int violation_severity,
+                  int& status, int& severity)
+{
+    if (not limits.valid) return;
+
+    bool const below = lowest < limits.low;
+    bool const above = highest > limits.high;
+    if (below and above) {
+        status = std::abs(lowest - limits.low) > std::abs(highest - limits.high) ? low_status : high_status;
+        severity = violation_severity;
+    } else if (below) {
+        status = low_status;
+        severity = violation_severity;
+    } else if (above) {
+        status = high_status;
+        severity = violation_severity;
+    }
+}
+
+bool apply_scalar_limits(PyObject* value, Limits const& control, PyObject*& result, double& lowest, double& highest)
+{
+    double number;
+    if (not to_double(value, number)) return false;
+
+    result = value;
+    if (control.valid) {
+        if (number > control.high) {
+            result = control.high_object;
+            number = control.high;
+        } else if (number < control.low) {
+            result = control.low_object;
+            number = control.low;
+        }
+    }
+    Py_INCREF(result);
+
+    lowest = number;
+    highest = number;
+    return true;
+}
+
+// Generic sequences become tuples if there are control limits
+bool apply_sequence_limits(PyObject* value, Limits const& control, PyObject*& result, double& lowest, double& highest)
+{
+    PyObject* sequence = PySequence_Fast(value, "Value must be a sequence");
+    if (not sequence) return false;
+
+    Py_ssize_t const size = PySequence_Fast_GET_SIZE(sequence);
+    PyObject** items = PySequence_Fast_ITEMS(sequence);
+
+    std::vector<double> numbers;
+    try {
+        numbers.resize(size);
+    } catch (...) {
+        Py_DECREF(sequence);
+        PyErr_NoMemory();
+        return false;
+    }
+    for (Py_ssize_t i = 0; i < size; ++i) {
+        if (not to_double(items[i], numbers[i])) {
+            Py_DECREF(sequence);
+            return false;
+        }
+    }
+    minmax_elements(numbers.data(), numbers.size(), lowest, highest);
+
+    if (not control.valid) {
+        Py_DECREF(sequence);
+        Py_INCREF(value);
+        result = value;
+        return true;
+    }
+
+    result = PyTuple_New(size);
+    if (not result) {
+        Py_DECREF(sequence);
+        return false;
+    }
+    for (Py_ssize_t i = 0; i < size; ++i) {
+        PyObject* item = items[i];
+        if (numbers[i] > control.high) {
+            item = control.high_object;
+        } else if (numbers[i] < control.low) {
+            item = control.low_object;
+        }
+        Py_INCREF(item);
+        PyTuple_SET_ITEM(result, i, item);
+    }
+    Py_DECREF(sequence);
+
+    if (lowest < control.low) lowest = control.low;
+    if (highest > control.high) highest = control.high;
+    return true;
+}
+
+#if CA_SERVER_NUMPY_SUPPORT
+
+// Limits in the element type, integer limits are rounded into the range
+template <typename T>
+auto element_limit(double limit, bool low) -> typename std::enable_if<std::is_integral<T>::value, T>::type
+{
+    limit = low ? std::ceil(limit) : std::floor(limit);
+    if (limit <= static_cast<double>(std::numeric_limits<T>::lowest())) return std::numeric_limits<T>::lowest();
+    if (limit >= static_cast<double>(std::numeric_limits<T>::max())) return std::numeric_limits<T>::max();
+    return static_cast<T>(limit);
+}
+
+template <typename T>
+auto element_limit(double limit, bool) -> typename std::enable_if<std::is_floating_point<T>::value, T>::type
+{
+    if (limit > static_cast<double>(std::numeric_limits<T>::max())) return std::numeric_limits<T>::infinity();
+    if (limit < static_cast<double>(std::numeric_limits<T>::lowest())) return -std::numeric_limits<T>::infinity();
+    return static_cast<T>(limit);
+}
+
+// ``array`` is C-contiguous with native byte order
+template <typename T>
+bool apply_array_limits(PyObject* value, PyArrayObject* array, Limits const& control, PyObject*& result, double& lowest, double& highest)
+{
+    auto const* data = static_cast<T const*>(PyArray_DATA(array));
+    std::size_t const size = PyArray_SIZE(array);
+
+    T low, high;
+    run_large(size, [&]() { minmax_elements(data, size, low, high); });
+
+    result = value;
+    Py_INCREF(result);
+
+    if (control.valid and size > 0) {
+        T const clamp_low = element_limit<T>(control.low, true);
+        T const clamp_high = element_limit<T>(control.high, false);
+        if (clamp_low <= clamp_high and (low < clamp_low or high > clamp_high)) {
+            // The caller's array stays unchanged, the copy is clamped in place
+            PyObject* copy = PyArray_NewCopy(array, NPY_CORDER);
+            if (not copy) {
+                Py_DECREF(result);
+                return false;
+            }
+            Py_DECREF(result);
+            result = copy;
+
+            auto* copy_data = static_cast<T*>(PyArray_DATA(reinterpret_cast<PyArrayObject*>(copy)));
+            run_large(size, [&]() { clamp_elements(copy_data, size, clamp_low, clamp_high); });
+
+            if (low < clamp_low) low = clamp_low;
+            if (high > clamp_high) high = clamp_high;
+        }
+    }
+
+    if (size > 0 and not (low > high)) {
+        lowest = static_cast<double>(low);
+        highest = static_cast<double>(high);
+    } else {
+        lowest = std::numeric_limits<double>::infinity();
+        highest = -std::numeric_limits<double>::infinity();
+    }
+    return true;
+}
+
+// ``handled`` is false for dtypes without a native implementation
+bool apply_numpy_limits(PyObject* value, Limits const& control, PyObject*& result, double& lowest, double& highest, bool& handled)
+{
+    int const typenum = PyArray_TYPE(reinterpret_cast<PyArrayObject*>(value));
+
+    bool (*apply)(PyObject*, PyArrayObject*, Limits const&, PyObject*&, double&, double&) = nullptr;
+    switch (typenum) {
+        case NPY_BYTE:      apply = apply_array_limits<npy_byte>;      break;
+        case NPY_UBYTE:     apply = apply_array_limits<npy_ubyte>;     break;
+        case NPY_SHORT:     apply = apply_array_limits<npy_short>;     break;
+        case NPY_USHORT:    apply = apply_array_limits<npy_ushort>;    break;
+        case NPY_INT:       apply = apply_array_limits<npy_int>;       break;
+        case NPY_UINT:      apply = apply_array_limits<npy_uint>;      break;
+        case NPY_LONG:      apply = apply_array_limits<npy_long>;      break;
+        case NPY_ULONG:     apply = apply_array_limits<npy_ulong>;     break;
+        case NPY_LONGLONG:  apply = apply_array_limits<npy_longlong>;  break;
+        case NPY_ULONGLONG: apply = apply_array_limits<npy_ulonglong>; break;
+        case NPY_FLOAT:     apply = apply_array_limits<npy_float>;     break;
+        case NPY_DOUBLE:    apply = apply_array_limits<npy_double>;    break;
+    }
+    handled = apply != nullptr;
+    if (not handled) return true;
+
+    // Returns value itself if it is already contiguous with native byte order
+    PyObject* contiguous = PyArray_FROMANY(value, typenum, 0, 0, NPY_ARRAY_CARRAY_RO);
+    if (not contiguous) return false;
+
+    bool const success = apply(value, reinterpret_cast<PyArrayObject*>(contiguous), control, result, lowest, highest);
+    Py_DECREF(contiguous);
+    return success;
+}
+
+template <typename T>
+void compare_arrays(PyArrayObject* values, PyArrayObject* old_values, Deadbands const& deadbands, bool& changed, double& difference)
+{
+    auto const* data = static_cast<T const*>(PyArray_DATA(values));
+    auto const* old_data = static_cast<T const*>(PyArray_DATA(old_values));
+    std::size_t const size = PyArray_SIZE(values);
+    run_large(size, [&]() {
+        compare_elements(data, old_data, size, deadbands.relative_tolerance, deadbands.absolute_tolerance, changed, difference);
+    });
+}
+
+// Arrays with the same dtype are compared with that type, all others as doubles
+bool compare_numpy(PyObject* value, PyObject* old_value, Deadbands const& deadbands, bool& changed, double& difference)
+{
+    int typenum = NPY_DOUBLE;
+    if (PyArray_Check(value) and PyArray_Check(old_value)) {
+        typenum = PyArray_TYPE(reinterpret_cast<PyArrayObject*>(value));
+        if (typenum != PyArray_TYPE(reinterpret_cast<PyArrayObject*>(old_value))) typenum = NPY_DOUBLE;
+    }
+
+    void (*compare)(PyArrayObject*, PyArrayObject*, Deadbands const&, bool&, double&) = nullptr;
+    switch (typenum) {
+        case NPY_BYTE:      compare = compare_arrays<npy_byte>;      break;
+        case NPY_UBYTE:     compare = compare_arrays<npy_ubyte>;     break;
+        case NPY_SHORT:     compare = compare_arrays<npy_short>;     break;
+        case NPY_USHORT:    compare = compare_arrays<npy_ushort>;    break;
+        case NPY_INT:       compare = compare_arrays<npy_int>;       break;
+        case NPY_UINT:      compare = compare_arrays<npy_uint>;      break;
+        case NPY_LONG:      compare = compare_arrays<npy_long>;      break;
+        case NPY_ULONG:     compare = compare_arrays<npy_ulong>;     break;
+        case NPY_LONGLONG:  compare = compare_arrays<npy_longlong>;  break;
+        case NPY_ULONGLONG: compare = compare_arrays<npy_ulonglong>; break;
+        case NPY_FLOAT:     compare = compare_arrays<npy_float>;     break;
+        default:
+            typenum = NPY_DOUBLE;
+            compare = compare_arrays<npy_double>;
+            break;
+    }
+
+    // Return the arguments themselves if they are contiguous with the right type
+    PyObject* values = PyArray_FROMANY(value, typenum, 0, 0, NPY_ARRAY_CARRAY_RO);
+    if (not values) return false;
+    PyObject* old_values = PyArray_FROMANY(old_value, typenum, 0, 0, NPY_ARRAY_CARRAY_RO);
+    if (not old_values) {
+        Py_DECREF(values);
+        return false;
+    }
+
+    auto* array = reinterpret_cast<PyArrayObject*>(values);
+    auto* old_array = reinterpret_cast<PyArrayObject*>(old_values);
+    if (PyArray_SIZE(array) == PyArray_SIZE(old_array)) {
+        compare(array, old_array, deadbands, changed, difference);
+    } else {
+        changed = true;
+        difference = std::numeric_limits<double>::infinity();
+    }
+
+    Py_DECREF(old_values);
+    Py_DECREF(values);
+    return true;
+}
+
+#endif
+
+bool to_doubles(PyObject* value, std::vector<double>& numbers)
+{
+    if (not PySequence_Check(value)) {
+        numbers.resize(1);
+        return to_double(value, numbers[0]);
+    }
+
+    PyObject* sequence = PySequence_Fast(value, "Value must be a sequence");
+    if (not sequence) return false;
+
+    Py_ssize_t const size = PySequence_Fast_GET_SIZE(sequence);
+    PyObject** items = PySequence_Fast_ITEMS(sequence);
+
+    bool success = true;
+    try {
+        numbers.resize(size);
+    } catch (...) {
+        PyErr_NoMemory();
+        success = false;
+    }
+    for (Py_ssize_t i = 0; success and i < size; ++i) {
+        success = to_double(items[i], numbers[i]);
+    }
+    Py_DECREF(sequence);
+    return success;
+}
+
+bool compare_values(PyObject* value, PyObject* old_value, Deadbands const& deadbands, bool& changed, double& difference)
+{
+#if CA_SERVER_NUMPY_SUPPORT
+    if (PyArray_Check(value) or PyArray_Check(old_value)) {
+        return compare_numpy(value, old_value, deadbands, changed, difference);
+    }
+#endif
+
+    std::vector<double> numbers, old_numbers;
+    if (not to_doubles(value, numbers)) return false;
+    if (not to_doubles(old_value, old_numbers)) return false;
+
+    if (numbers.size() == old_numbers.size()) {
+        compare_elements(numbers.data(), old_numbers.data(), numbers.size(),
+            deadbands.relative_tolerance, deadbands.absolute_tolerance, changed, difference);
+    } else {
+        changed = true;
+        difference = std::numeric_limits<double>::infinity();
+    }
+    return true;
+}
+
+}
+
+bool value_events(PyObject* value, PyObject* old_value, Deadbands const& deadbands, bool& changed, unsigned& events)
+{
+    double difference;
+    if (not compare_values(value, old_value, deadbands, changed, difference)) {
+        // e.g. None or integers out of the double range
+        if (not PyErr_ExceptionMatches(PyExc_TypeError) and not PyErr_ExceptionMatches(PyExc_ValueError) and
+                not PyErr_ExceptionMatches(PyExc_OverflowError)) {
+            return false;
+        }
+        PyErr_Clear();
+        changed = true;
+        difference = std::numeric_limits<double>::infinity();
+    }
+
+    events = 0;
+    if (changed) {
+        if (difference >= deadbands.value) events |= DBE_VALUE;
+        if (difference >= deadbands.archive) events |= DBE_ARCHIVE;
+    }
+    return true;
+}
+
+bool to_limits(PyObject* obj, Limits& limits)
+{
+    limits.valid = false;
+    if (obj == Py_None) return true;
+
+    if (not PyTuple_Check(obj) and not PyList_Check(obj)) {
+        PyErr_SetString(PyExc_TypeError, "Limits must be a (low, high) tuple");
+        return false;
+    }
+    if (PySequence_Fast_GET_SIZE(obj) != 2) {
+        PyErr_SetString(PyExc_ValueError, "Limits must have two elements");
+        return false;
+    }
+
+    limits.low_object = PySequence_Fast_GET_ITEM(obj, 0);
+    limits.high_object = PySequence_Fast_GET_ITEM(obj, 1);
+    if (not to_double(limits.low_object, limits.low)) return false;
+    if (not to_double(limits.high_object, limits.high)) return false;
+
+    limits.valid = limits.low < limits.high;
+    return true;
+}
+
+bool apply_limits(PyObject* value, Limits const& control, Limits const& warning, Limits const& alarm,
+                  PyObject*& result, int& status, int& severity)
+{
+    double lowest, highest;
+    bool handled = false;
+
+#if CA_SERVER_NUMPY_SUPPORT
+    if (PyArray_Check(value)) {
+        if (not apply_numpy_limits(value, control, result, lowest, highest, handled)) return false;
+    }
+#endif
+
+    if (not handled) {
+        bool const success = PySequence_Check(value)
+            ? apply_sequence_limits(value, control, result, lowest, highest)
+            : apply_scalar_limits(value, control, result, lowest, highest);
+        if (not success) return false;
+    }
+
+    status = epicsAlarmNone;
+    severity = epicsSevNone;
+    check_limits(lowest, highest, warning, epicsAlarmLow, epicsAlarmHigh, epicsSevMinor, status, severity);
+    check_limits(lowest, highest, alarm, epicsAlarmLoLo, epicsAlarmHiHi, epicsSevMajor, status, severity);
+    return true;
+}
+
+}
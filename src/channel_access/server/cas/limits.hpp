@@ -0,0 +1,59 @@
+#ifndef INCLUDE_GUARD_A3F19C2E_7D4B_4E86_B0C1_58E2D947F13A
+#define INCLUDE_GUARD_A3F19C2E_7D4B_4E86_B0C1_58E2D947F13A
+
+#include <Python.h>
+
+namespace cas {
+
+/** A ``(low, high)`` limits pair.
+ */
+struct Limits {
+    // False if there are no limits or low >= high
+    bool valid;
+    double low;
+    double high;
+    // Borrowed from the limits tuple
+    PyObject* low_object;
+    PyObject* high_object;
+};
+
+/** Read a limits tuple or list, ``None`` is no limits.
+ * The limits borrow the elements of ``obj``.
+ */
+bool to_limits(PyObject* obj, Limits& limits);
+
+/** Clamp ``value`` to the control limits and calculate status and
+ * severity from the warning and alarm limits.
+ *
+ * ``result`` is a new reference to the clamped value. Elements
+ * outside of the control limits are replaced by the limit objects,
+ * numpy arrays are copied with the same dtype only if they have to
+ * be clamped.
+ */
+bool apply_limits(PyObject* value, Limits const& control, Limits const& warning, Limits const& alarm,
+                  PyObject*& result, int& status, int& severity);
+
+/** Tolerances and deadbands for value changes.
+ */
+struct Deadbands {
+    double relative_tolerance;
+    double absolute_tolerance;
+    double value;
+    double archive;
+};
+
+/** Compare a number or an array of numbers with the old value.
+ *
+ * ``changed`` is false if all elements are close within the tolerances
+ * (like ``math.isclose()``). ``events`` contains ``DBE_VALUE`` and
+ * ``DBE_ARCHIVE`` if the largest absolute difference reaches the
+ * respective deadband. Both are computed in one pass.
+ *
+ * Values which can not be compared as numbers count as changed beyond
+ * all deadbands.
+ */
+bool value_events(PyObject* value, PyObject* old_value, Deadbands const& deadbands, bool& changed, unsigned& events);
+
+}
+
+#endif
@@ -1,14 +1,21 @@
 #include "pv.hpp"
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <Python.h>
 #include <structmember.h>
 #include <casdef.h>
 #include <gddApps.h>
+#include <gddAppTable.h>
 
 #include "cas.hpp"
 #include "convert.hpp"
 #include "async.hpp"
+#include "attributes.hpp"
+#include "rate_limiter.hpp"
+#include "event_queue.hpp"
 
 namespace cas {
 namespace {
@@ -19,7 +26,9 @@ struct Pv {
     char* name;
     bool held_by_server;
     char use_numpy;
+    char numpy_views;
     std::unique_ptr<PvProxy> proxy;
+    std::shared_ptr<Registry> registry;
 };
 static_assert(std::is_standard_layout<Pv>::value, "Pv has to be standard layout to work with the Python API");
 
@@ -27,11 +36,28 @@ static_assert(std::is_standard_layout<Pv>::value, "Pv has to be standard layout
 class PvProxy : public casPV {
 public:
     PvProxy(PyObject* pv)
-        : pv{pv}
+        : pv{pv}, type_info{0}, stored_value{nullptr}, stored_metadata{nullptr}, rate_limiter{nullptr}, queued_events{0}
     {
         // No GIL, don't use the python API
     }
 
+    virtual ~PvProxy()
+    {
+        // No GIL, don't use the python API
+
+        // Queued events reference this PV, post them before it is gone
+        if (queued_events.load() > 0) {
+            drain_event_queue();
+        }
+        delete rate_limiter.load();
+        if (stored_value) {
+            stored_value->unreference();
+        }
+        if (stored_metadata) {
+            stored_metadata->unreference();
+        }
+    }
+
     static PyObject* name(PyObject* self, PyObject*)
     {
         return Py_BuildValue("y", reinterpret_cast<Pv*>(self)->name);
@@ -79,21 +105,13 @@ public:
 
     virtual aitEnum bestExternalType() const override
     {
+        TypeInfo info;
+        if (cachedTypeInfo(info)) return info.type;
+
         aitEnum ret = aitEnumString;
         PyGILState_STATE gstate = PyGILState_Ensure();
-            PyObject* fn = PyObject_GetAttrString(pv, "type");
-            if (fn) {
-                PyObject* result = PyObject_CallFunction(fn, nullptr);
-                if (PyErr_Occurred()) {
-                    PyErr_WriteUnraisable(fn);
-                    PyErr_Clear();
-                }
-                Py_DECREF(fn);
-
-                if (result) {
-                    to_ait_enum(result, ret);
-                    Py_DECREF(result);
-                }
+            if (loadTypeInfo(info)) {
+                ret = info.type;
             }
 
             if (PyErr_Occurred()) {
@@ -111,21 +129,13 @@ public:
 
     virtual unsigned maxDimension() const override
     {
+        TypeInfo info;
+        if (cachedTypeInfo(info)) return info.is_array ? 1 : 0;
+
         unsigned ret = 0;
         PyGILState_STATE gstate = PyGILState_Ensure();
-            PyObject* fn = PyObject_GetAttrString(pv, "count");
-            if (fn) {
-                PyObject* result = PyObject_CallFunction(fn, nullptr);
-                if (PyErr_Occurred()) {
-                    PyErr_WriteUnraisable(fn);
-                    PyErr_Clear();
-                }
-                Py_DECREF(fn);
-
-                if (PyLong_Check(result)) {
-                    ret = 1;
-                }
-                Py_XDECREF(result);
+            if (loadTypeInfo(info) and info.is_array) {
+                ret = 1;
             }
 
             if (PyErr_Occurred()) {
@@ -138,25 +148,13 @@ public:
 
     virtual aitIndex maxBound(unsigned dimension) const override
     {
+        TypeInfo info;
+        if (cachedTypeInfo(info)) return info.count;
+
         aitIndex ret = 0;
         PyGILState_STATE gstate = PyGILState_Ensure();
-            PyObject* fn = PyObject_GetAttrString(pv, "count");
-            if (fn) {
-                PyObject* result = PyObject_CallFunction(fn, nullptr);
-                if (PyErr_Occurred()) {
-                    PyErr_WriteUnraisable(fn);
-                    PyErr_Clear();
-                }
-                Py_DECREF(fn);
-
-                if (result) {
-                    aitIndex bound = PyLong_AsLong(result);
-                    if (not PyErr_Occurred()) {
-                        ret = bound;
-                    }
-
-                    Py_DECREF(result);
-                }
+            if (loadTypeInfo(info)) {
+                ret = info.count;
             }
 
             if (PyErr_Occurred()) {
@@ -174,24 +172,32 @@ public:
 
     virtual caStatus read(casCtx const& ctx, gdd& prototype) override
     {
-        aitEnum type = aitEnumInvalid;
+        gdd* value;
+        gdd* metadata;
+        acquireStore(value, metadata);
+
+        // Attributes in the native store are served without the GIL
+        if (value) {
+            bool success = (not metadata or copy_metadata(*metadata, prototype))
+                and copy_value(*value, prototype);
+            value->unreference();
+            if (metadata) {
+                metadata->unreference();
+            }
+            return success ? S_casApp_success : S_casApp_noSupport;
+        }
+        if (metadata) {
+            // The read handler can change the meta data, acquire it again afterwards
+            metadata->unreference();
+            metadata = nullptr;
+        }
+
         caStatus ret = S_casApp_noSupport;
         PyGILState_STATE gstate = PyGILState_Ensure();
-            {
-                PyObject* fn = PyObject_GetAttrString(pv, "type");
-                if (fn) {
-                    PyObject* result = PyObject_CallFunction(fn, nullptr);
-                    if (PyErr_Occurred()) {
-                        PyErr_WriteUnraisable(fn);
-                        PyErr_Clear();
-                    }
-                    Py_DECREF(fn);
-
-                    if (result) {
-                        to_ait_enum(result, type);
-                        Py_DECREF(result);
-                    }
-                }
+            TypeInfo info;
+            aitEnum type = aitEnumInvalid;
+            if (loadTypeInfo(info)) {
+                type = info.type;
             }
 
             if (type != aitEnumInvalid) {
@@ -208,6 +214,11 @@ public:
                     if (result and result != Py_None) {
                         if (give_async_read_to_server(result)) {
                             ret = S_casApp_asyncCompletion;
+                        } else if ((metadata = acquireMetadata())) {
+                            // Only the value has to be converted
+                            if (copy_metadata(*metadata, prototype) and to_gdd_value(result, type, prototype)) {
+                                ret = S_casApp_success;
+                            }
                         } else if (to_gdd(result, type, prototype)) {
                             ret = S_casApp_success;
                         }
@@ -221,6 +232,10 @@ public:
                 PyErr_Clear();
             }
         PyGILState_Release(gstate);
+
+        if (metadata) {
+            metadata->unreference();
+        }
         return ret;
     }
 
@@ -237,7 +252,7 @@ public:
         PyGILState_STATE gstate = PyGILState_Ensure();
             PyObject* fn = PyObject_GetAttrString(pv, "write");
             if (fn) {
-                PyObject* value_timestamp = from_gdd(value, pv_struct->use_numpy);
+                PyObject* value_timestamp = from_gdd(value, pv_struct->use_numpy, pv_struct->numpy_views);
                 if (value_timestamp) {
                     PyObject* result = PyObject_CallFunction(fn, "(OON)",
                         PyTuple_GET_ITEM(value_timestamp, 0),
@@ -281,57 +296,205 @@ public:
 
         if (not PyArg_ParseTuple(args, "OO", &py_events, &py_values)) return nullptr;
 
+        std::vector<PreparedEvent> events(1);
+        if (not proxy->prepareEvent(py_events, py_values, events[0])) return nullptr;
 
-        PyObject* fn = PyObject_GetAttrString(proxy->pv, "type");
-        if (not fn) return nullptr;
+        bool success;
+        Py_BEGIN_ALLOW_THREADS
+            success = post_events(events);
+        Py_END_ALLOW_THREADS
+
+        if (not success) {
+            PyErr_SetString(PyExc_RuntimeError, "Could not post events");
+            return nullptr;
+        }
+        Py_RETURN_NONE;
+    }
 
-        PyObject* result = PyObject_CallFunction(fn, nullptr);
-        Py_DECREF(fn);
-        if (not result) return nullptr;
+    // GIL must be held, returns false with an exception set on errors
+    bool prepareEvent(PyObject* py_events, PyObject* py_values, PreparedEvent& event)
+    {
+        event.pv = this;
+        event.values = nullptr;
 
-        aitEnum type = aitEnumInvalid;
-        bool success = to_ait_enum(result, type);
-        Py_DECREF(result);
-        if (not success) return nullptr;
+        TypeInfo info;
+        if (not loadTypeInfo(info)) return false;
 
+        aitEnum type = info.type;
         if (type == aitEnumInvalid) {
             PyErr_SetString(PyExc_RuntimeError, "Invalid pv type");
-            return nullptr;
+            return false;
         }
 
-
-        caServer const* server;
-        Py_BEGIN_ALLOW_THREADS
-            server = static_cast<casPV*>(proxy)->getCAS();
-        Py_END_ALLOW_THREADS
+        // getCAS() only reads a pointer, no need to release the GIL
+        caServer const* server = getCAS();
         if (not server) {
             // not installed into a server, do nothing
-            Py_RETURN_NONE;
+            return true;
         }
 
-        casEventMask mask;
-        if (not to_event_mask(py_events, mask, *server)) return nullptr;
+        if (not to_event_mask(py_events, event.mask, *server)) return false;
 
         auto* values = new gdd{gddAppType_value};
         if (not to_gdd(py_values, type, *values)) {
             values->unreference();
+            return false;
+        }
+
+        event.values = values;
+        return true;
+    }
+
+    static PyObject* postValue(PyObject* self, PyObject* args, PyObject* kwds)
+    {
+        PvProxy* proxy = reinterpret_cast<Pv*>(self)->proxy.get();
+
+        static char const* keywords[] = {"events", "value", "status", "severity", "timestamp", nullptr};
+        PyObject* py_events, *py_value, *py_status = nullptr, *py_severity = nullptr, *py_timestamp = Py_None;
+        if (not PyArg_ParseTupleAndKeywords(args, kwds, "OO|OOO:postValue", const_cast<char**>(keywords),
+                &py_events, &py_value, &py_status, &py_severity, &py_timestamp)) {
             return nullptr;
         }
 
-        try {
-            Py_BEGIN_ALLOW_THREADS
-                static_cast<casPV*>(proxy)->postEvent(mask, *values);
-            Py_END_ALLOW_THREADS
-        } catch (...) {
+        TypeInfo info;
+        if (not proxy->loadTypeInfo(info)) return nullptr;
+
+        if (info.type == aitEnumInvalid) {
+            PyErr_SetString(PyExc_RuntimeError, "Invalid pv type");
+            return nullptr;
+        }
+
+        int status = 0, severity = 0;
+        if (py_status and not enum_to_int(py_status, status)) return nullptr;
+        if (py_severity and not enum_to_int(py_severity, severity)) return nullptr;
+
+        epicsTimeStamp timestamp;
+        if (not to_epics_timestamp(py_timestamp, timestamp)) return nullptr;
+
+        // gdds are allocated from the gdd free list
+        auto* values = new gdd{gddAppType_value, info.type};
+        if (not value_to_gdd(py_value, info.type, *values)) {
             values->unreference();
-            PyErr_SetString(PyExc_RuntimeError, "Could not post events");
             return nullptr;
         }
+        values->setStatSevr(status, severity);
+        values->setTimeStamp(&timestamp);
+
+        proxy->updateStoredValue(values);
+
+        caServer const* server = static_cast<casPV*>(proxy)->getCAS();
+        if (server) {
+            casEventMask mask;
+            if (not to_event_mask(py_events, mask, *server)) {
+                values->unreference();
+                return nullptr;
+            }
+
+            try {
+                Py_BEGIN_ALLOW_THREADS
+                    proxy->post(mask, *values);
+                Py_END_ALLOW_THREADS
+            } catch (...) {
+                values->unreference();
+                PyErr_SetString(PyExc_RuntimeError, "Could not post events");
+                return nullptr;
+            }
+        }
         values->unreference();
 
         Py_RETURN_NONE;
     }
 
+    // Post an event, through the event queue if it is enabled and
+    // the rate limiter if there is one. Does not need the GIL.
+    void post(casEventMask const& mask, gdd& values)
+    {
+        queued_events.fetch_add(1);
+        if (enqueue_event(*this, mask, values)) return;
+        if (queued_events.fetch_sub(1) > 1) {
+            // Older events of this PV are still queued, post them
+            // first or clients would end on a stale value
+            drain_event_queue();
+        }
+
+        dispatch(mask, values);
+    }
+
+    // Post a dequeued event, does not need the GIL
+    void postQueued(casEventMask const& mask, gdd& values)
+    {
+        try {
+            dispatch(mask, values);
+        } catch (...) {
+            // Nobody to report to from the queue
+        }
+        queued_events.fetch_sub(1);
+    }
+
+    void dispatch(casEventMask const& mask, gdd& values)
+    {
+        EventRateLimiter* limiter = rate_limiter.load();
+        if (limiter) {
+            limiter->post(mask, values);
+        } else {
+            casPV::postEvent(mask, values);
+        }
+    }
+
+    static PyObject* setMaxEventRate(PyObject* self, PyObject* arg)
+    {
+        PvProxy* proxy = reinterpret_cast<Pv*>(self)->proxy.get();
+
+        double rate = PyFloat_AsDouble(arg);
+        if (PyErr_Occurred()) return nullptr;
+        if (rate < 0.0) {
+            PyErr_SetString(PyExc_ValueError, "The event rate must not be negative");
+            return nullptr;
+        }
+
+        // Created once and kept until the PV is deleted, the GIL serializes this
+        EventRateLimiter* limiter = proxy->rate_limiter.load();
+        if (not limiter) {
+            if (rate == 0.0) Py_RETURN_NONE;
+
+            try {
+                limiter = new EventRateLimiter{*proxy};
+            } catch (...) {
+                PyErr_NoMemory();
+                return nullptr;
+            }
+            proxy->rate_limiter.store(limiter);
+        }
+
+        // Disabling the limit posts the pending event
+        Py_BEGIN_ALLOW_THREADS
+            limiter->setMaxRate(rate);
+        Py_END_ALLOW_THREADS
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* maxEventRate(PyObject* self, PyObject*)
+    {
+        PvProxy* proxy = reinterpret_cast<Pv*>(self)->proxy.get();
+
+        EventRateLimiter* limiter = proxy->rate_limiter.load();
+        return PyFloat_FromDouble(limiter ? limiter->maxRate() : 0.0);
+    }
+
+    static PyObject* eventStatistics(PyObject* self, PyObject*)
+    {
+        PvProxy* proxy = reinterpret_cast<Pv*>(self)->proxy.get();
+
+        std::uint64_t conflated = 0, dropped = 0;
+        EventRateLimiter* limiter = proxy->rate_limiter.load();
+        if (limiter) {
+            limiter->statistics(conflated, dropped);
+        }
+        return Py_BuildValue("{sKsK}",
+            "conflated", static_cast<unsigned long long>(conflated),
+            "dropped", static_cast<unsigned long long>(dropped));
+    }
+
     virtual caStatus interestRegister() override
     {
         caStatus ret = S_casApp_noSupport;
@@ -393,10 +556,240 @@ public:
         Py_RETURN_NONE;
     }
 
+    static PyObject* storeAttributes(PyObject* self, PyObject* args)
+    {
+        PvProxy* proxy = reinterpret_cast<Pv*>(self)->proxy.get();
+
+        PyObject* attributes;
+        int update_metadata = true;
+        if (not PyArg_ParseTuple(args, "O|p:storeAttributes", &attributes, &update_metadata)) return nullptr;
+
+        TypeInfo info;
+        if (not proxy->loadTypeInfo(info)) return nullptr;
+
+        if (info.type == aitEnumInvalid) {
+            PyErr_SetString(PyExc_RuntimeError, "Invalid pv type");
+            return nullptr;
+        }
+
+        gdd* value = new gdd{gddAppType_value, info.type};
+        if (not to_gdd(attributes, info.type, *value)) {
+            value->unreference();
+            return nullptr;
+        }
+
+        gdd* metadata = nullptr;
+        if (update_metadata and not proxy->createMetadata(attributes, info.type, metadata)) {
+            value->unreference();
+            return nullptr;
+        }
+
+        proxy->replaceStore(value, metadata, update_metadata);
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* storeMetadata(PyObject* self, PyObject* attributes)
+    {
+        PvProxy* proxy = reinterpret_cast<Pv*>(self)->proxy.get();
+
+        TypeInfo info;
+        if (not proxy->loadTypeInfo(info)) return nullptr;
+
+        if (info.type == aitEnumInvalid) {
+            PyErr_SetString(PyExc_RuntimeError, "Invalid pv type");
+            return nullptr;
+        }
+
+        gdd* metadata = nullptr;
+        if (not proxy->createMetadata(attributes, info.type, metadata)) return nullptr;
+
+        std::lock_guard<std::mutex> lock(proxy->store_mutex);
+        std::swap(proxy->stored_metadata, metadata);
+        if (metadata) {
+            metadata->unreference();
+        }
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* clearStore(PyObject* self, PyObject*)
+    {
+        PvProxy* proxy = reinterpret_cast<Pv*>(self)->proxy.get();
+
+        proxy->replaceStore(nullptr, nullptr, true);
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* invalidateTypeInfo(PyObject* self, PyObject*)
+    {
+        PvProxy* proxy = reinterpret_cast<Pv*>(self)->proxy.get();
+
+        proxy->invalidateTypeInfo();
+        Py_RETURN_NONE;
+    }
+
+    void invalidateTypeInfo()
+    {
+        // Bump the generation so a concurrent loadTypeInfo() does not store stale values
+        std::uint64_t packed = type_info.load();
+        while (not type_info.compare_exchange_weak(packed, (packed + info_generation_one) & info_generation_mask)) {}
+    }
+
 private:
+    struct TypeInfo {
+        aitEnum type;
+        bool is_array;
+        aitIndex count;
+    };
+
+    // type_info layout: valid flag (bit 63), generation (bits 40-62),
+    // type (bits 32-39) and count + 1 or 0 for scalars (bits 0-31)
+    static constexpr std::uint64_t info_valid = std::uint64_t{1} << 63;
+    static constexpr std::uint64_t info_generation_one = std::uint64_t{1} << 40;
+    static constexpr std::uint64_t info_generation_mask = info_valid - info_generation_one;
+
+    // Does not need the GIL
+    bool cachedTypeInfo(TypeInfo& info) const
+    {
+        std::uint64_t const packed = type_info.load();
+        if (not (packed & info_valid)) return false;
+
+        std::uint32_t const count = packed & 0xffffffffu;
+        info.type = static_cast<aitEnum>((packed >> 32) & 0xff);
+        info.is_array = count > 0;
+        info.count = count > 0 ? count - 1 : 0;
+        return true;
+    }
+
+    // Call the python methods type() and count() and cache the result.
+    // GIL must be held, returns false with an exception set on errors
+    bool loadTypeInfo(TypeInfo& info) const
+    {
+        if (cachedTypeInfo(info)) return true;
+        std::uint64_t before = type_info.load();
+
+        PyObject* type_result = PyObject_CallMethod(pv, "type", nullptr);
+        if (not type_result) return false;
+
+        info.type = aitEnumInvalid;
+        bool success = to_ait_enum(type_result, info.type);
+        Py_DECREF(type_result);
+        if (not success) return false;
+
+        PyObject* count_result = PyObject_CallMethod(pv, "count", nullptr);
+        if (not count_result) return false;
+
+        info.is_array = PyLong_Check(count_result);
+        info.count = 0;
+        if (info.is_array) {
+            info.count = PyLong_AsUnsignedLong(count_result);
+        }
+        Py_DECREF(count_result);
+        if (PyErr_Occurred()) return false;
+
+        std::uint64_t const packed = info_valid | (before & info_generation_mask)
+            | (static_cast<std::uint64_t>(info.type) << 32)
+            | (info.is_array ? static_cast<std::uint64_t>(info.count) + 1 : 0);
+        // Fails if the type info was invalidated in the meantime
+        type_info.compare_exchange_strong(before, packed);
+        return true;
+    }
+
+    // Create the meta data gdd, strings have no meta data.
+    // GIL must be held, returns false with an exception set on errors
+    bool createMetadata(PyObject* attributes, aitEnum type, gdd*& metadata) const
+    {
+        metadata = nullptr;
+        if (type == aitEnumString) return true;
+
+        metadata = create_attributes_gdd(type);
+        if (not metadata) return false;
+
+        if (not to_gdd(attributes, type, *metadata)) {
+            metadata->unreference();
+            metadata = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    // Return new references to the stored value and meta data, each can be nullptr
+    void acquireStore(gdd*& value, gdd*& metadata)
+    {
+        std::lock_guard<std::mutex> lock(store_mutex);
+        value = stored_value;
+        metadata = stored_metadata;
+        if (value) {
+            value->reference();
+        }
+        if (metadata) {
+            metadata->reference();
+        }
+    }
+
+    // Replace the stored value if attributes are stored, ``value`` is shared
+    void updateStoredValue(gdd* value)
+    {
+        gdd* old_value;
+        {
+            std::lock_guard<std::mutex> lock(store_mutex);
+            if (not stored_value) return;
+
+            value->reference();
+            old_value = stored_value;
+            stored_value = value;
+        }
+        old_value->unreference();
+    }
+
+    // Return a new reference to the stored meta data or nullptr
+    gdd* acquireMetadata()
+    {
+        std::lock_guard<std::mutex> lock(store_mutex);
+        if (stored_metadata) {
+            stored_metadata->reference();
+        }
+        return stored_metadata;
+    }
+
+    // Takes ownership of ``value`` and ``metadata``.
+    // The meta data is only replaced if ``replace_metadata`` is true.
+    void replaceStore(gdd* value, gdd* metadata, bool replace_metadata)
+    {
+        {
+            std::lock_guard<std::mutex> lock(store_mutex);
+            std::swap(stored_value, value);
+            if (replace_metadata) {
+                std::swap(stored_metadata, metadata);
+            }
+        }
+        // Release the old gdds outside of the lock
+        if (value) {
+            value->unreference();
+        }
+        if (metadata) {
+            metadata->unreference();
+        }
+    }
+
     PyObject* pv;
+    mutable std::atomic<std::uint64_t> type_info;
+
+    // Native copy of the attributes, read() uses it instead of calling python.
+    // The meta data is stored separately because it changes rarely.
+    std::mutex store_mutex;
+    gdd* stored_value;
+    gdd* stored_metadata;
+
+    // Created by setMaxEventRate(), nullptr if events are never limited
+    std::atomic<EventRateLimiter*> rate_limiter;
+    // Number of events in the event queue for this PV
+    std::atomic<unsigned> queued_events;
 };
 
+constexpr std::uint64_t PvProxy::info_valid;
+constexpr std::uint64_t PvProxy::info_generation_one;
+constexpr std::uint64_t PvProxy::info_generation_mask;
+
 
 int pv_init(PyObject* self, PyObject* args, PyObject*)
 {
@@ -406,6 +799,13 @@ int pv_init(PyObject* self, PyObject* args, PyObject*)
     int numpy = false;
     if (not PyArg_ParseTuple(args, "y|p", &c_name, &numpy)) return -1;
 
+    // The name changes, a registration under the old name is invalid
+    if (pv->registry) {
+        pv->registry->remove(pv->name, self);
+        pv->registry.reset();
+    }
+    free(pv->name);
+
     pv->name = strdup(c_name);
     pv->held_by_server = false;
     pv->use_numpy = numpy;
@@ -416,6 +816,13 @@ void pv_dealloc(PyObject* self)
 {
     Pv* pv = reinterpret_cast<Pv*>(self);
 
+    // Remove the name before releasing the GIL, the server only uses
+    // registry entries while holding it.
+    if (pv->registry) {
+        pv->registry->remove(pv->name, self);
+        pv->registry.reset();
+    }
+
     free(pv->name);
     Py_BEGIN_ALLOW_THREADS
         pv->proxy.reset();
@@ -461,6 +868,7 @@ PyDoc_STRVAR(type__doc__, R"(type()
 Return the type of the PV.
 
 This is called from the server when the PV type is needed.
+The result is cached until :meth:`invalidateTypeInfo` is called.
 
 This is called from an unspecified thread.
 
@@ -474,6 +882,7 @@ Return the number of elements.
 This is called from the server when the number of elements is needed for
 an array pv.
 Return ``None`` for a scalar PV.
+The result is cached until :meth:`invalidateTypeInfo` is called.
 
 This is called from an unspecified thread.
 
@@ -484,7 +893,8 @@ PyDoc_STRVAR(read__doc__, R"(read(context)
 
 Retreive the attributes of the PV.
 
-This is called from the server when a get request is processed.
+This is called from the server when a get request is processed and
+no attributes are stored with :meth:`storeAttributes`.
 
 This is called from an unspecified thread.
 
@@ -492,7 +902,8 @@ Args:
     context: A context object needed to create an :class:`AsyncRead` object.
 
 Returns:
-    dict: An attributes dictionary with all PV attributes.
+    dict|Attributes: An attributes dictionary or :class:`Attributes`
+    object with all PV attributes.
 )");
 PyDoc_STRVAR(write__doc__, R"(write(value, timestamp, context)
 
@@ -523,9 +934,62 @@ This method is thread-safe.
 Args:
     event_mask (:class:`channel_access.common.Events`): This mask describes
         the events to post.
-    attributes (dict): An attribute dictionary with the attribute values for the events.
+    attributes (dict|Attributes): An attribute dictionary or :class:`Attributes`
+        object with the attribute values for the events.
 
 )");
+PyDoc_STRVAR(postValue__doc__, R"(postValue(events, value, status=0, severity=0, timestamp=None)
+
+Post a value change to clients.
+
+Faster alternative to :meth:`postEvent` if only value, status,
+severity and timestamp changed. No attributes dictionary is needed
+and the cached type of the PV is used.
+
+Only if attributes are stored with :meth:`storeAttributes` the stored
+value is replaced and reads return the posted value. Otherwise this
+only notifies monitors and reads still call :meth:`read`. The stored
+value is never created here because the meta data would be missing.
+
+This method is thread-safe.
+
+Args:
+    events (int|:class:`channel_access.common.Events`): The events to post.
+    value: The new value, like the ``value`` attribute.
+    status (int|:class:`channel_access.common.Status`): Status.
+    severity (int|:class:`channel_access.common.Severity`): Severity.
+    timestamp: A :class:`datetime.datetime`, a POSIX timestamp or an
+        epics ``(seconds, nanoseconds)`` tuple. ``None`` uses the
+        current time.
+)");
+PyDoc_STRVAR(setMaxEventRate__doc__, R"(setMaxEventRate(rate)
+
+Limit the events posted for this PV to ``rate`` events per second.
+
+Events arriving faster are conflated: only the latest values are kept,
+together with the union of the event masks, and they are posted by a
+timer of the server loop (:func:`process`). Use ``0`` to disable the
+limit, a conflated event is posted immediately.
+
+This method is thread-safe.
+)");
+PyDoc_STRVAR(maxEventRate__doc__, R"(maxEventRate()
+
+Return the maximum number of events per second, ``0`` if not limited.
+
+This method is thread-safe.
+)");
+PyDoc_STRVAR(eventStatistics__doc__, R"(eventStatistics()
+
+Return statistics of the event rate limit.
+
+This method is thread-safe.
+
+Returns:
+    dict: A dictionary with the keys ``conflated`` (events delayed by the
+    limit) and ``dropped`` (delayed values replaced by newer ones before
+    they were posted).
+)");
 PyDoc_STRVAR(interestRegister__doc__, R"(interestRegister()
 
 Request to inform the server about changes.
@@ -547,6 +1011,54 @@ when attributes change.
 
 This is called from an unspecified thread.
 )");
+PyDoc_STRVAR(storeAttributes__doc__, R"(storeAttributes(attributes, update_metadata=True)
+
+Store the attributes in native storage.
+
+Once attributes are stored, read requests are answered from the
+native storage without calling :meth:`read` and without taking the
+GIL. Call this again whenever the attributes change.
+
+This method is thread-safe.
+
+Args:
+    attributes (dict|Attributes): Attributes dictionary with all attributes,
+        like the one returned by :meth:`read`.
+    update_metadata (bool): If ``False`` only value, status, severity
+        and timestamp are stored and the stored meta data is kept.
+        Use this when no :class:`Events.PROPERTY` event occured.
+)");
+PyDoc_STRVAR(storeMetadata__doc__, R"(storeMetadata(attributes)
+
+Cache the meta data of the PV.
+
+Requests for meta data (e.g. ``DBR_CTRL_*``) only convert the value
+returned by :meth:`read` and copy the meta data from this cache.
+Call this whenever a :class:`Events.PROPERTY` event occurs.
+
+This method is thread-safe.
+
+Args:
+    attributes (dict|Attributes): Attributes dictionary with all attributes.
+)");
+PyDoc_STRVAR(clearStore__doc__, R"(clearStore()
+
+Discard the attributes stored with :meth:`storeAttributes` and
+:meth:`storeMetadata`.
+
+Read requests call :meth:`read` again.
+
+This method is thread-safe.
+)");
+PyDoc_STRVAR(invalidateTypeInfo__doc__, R"(invalidateTypeInfo()
+
+Discard the cached results of :meth:`type` and :meth:`count`.
+
+Call this when the number of elements changes. The methods are called
+again when the server needs the values.
+
+This method is thread-safe.
+)");
 
 PyMethodDef pv_methods[] = {
     {"name",             static_cast<PyCFunction>(PvProxy::name),             METH_NOARGS,  name__doc__},
@@ -556,8 +1068,16 @@ PyMethodDef pv_methods[] = {
     {"read",             static_cast<PyCFunction>(PvProxy::read),             METH_NOARGS,  read__doc__},
     {"write",            static_cast<PyCFunction>(PvProxy::write),            METH_VARARGS, write__doc__},
     {"postEvent",        static_cast<PyCFunction>(PvProxy::postEvent),        METH_VARARGS, postEvent__doc__},
+    {"postValue",        reinterpret_cast<PyCFunction>(PvProxy::postValue),   METH_VARARGS | METH_KEYWORDS, postValue__doc__},
+    {"setMaxEventRate",  static_cast<PyCFunction>(PvProxy::setMaxEventRate),  METH_O,       setMaxEventRate__doc__},
+    {"maxEventRate",     static_cast<PyCFunction>(PvProxy::maxEventRate),     METH_NOARGS,  maxEventRate__doc__},
+    {"eventStatistics",  static_cast<PyCFunction>(PvProxy::eventStatistics),  METH_NOARGS,  eventStatistics__doc__},
     {"interestRegister", static_cast<PyCFunction>(PvProxy::interestRegister), METH_NOARGS,  interestRegister__doc__},
     {"interestDelete",   static_cast<PyCFunction>(PvProxy::interestDelete),   METH_NOARGS,  interestDelete__doc__},
+    {"storeAttributes",  static_cast<PyCFunction>(PvProxy::storeAttributes),  METH_VARARGS, storeAttributes__doc__},
+    {"storeMetadata",    static_cast<PyCFunction>(PvProxy::storeMetadata),    METH_O,       storeMetadata__doc__},
+    {"clearStore",       static_cast<PyCFunction>(PvProxy::clearStore),       METH_NOARGS,  clearStore__doc__},
+    {"invalidateTypeInfo", static_cast<PyCFunction>(PvProxy::invalidateTypeInfo), METH_NOARGS, invalidateTypeInfo__doc__},
     {nullptr}
 };
 
@@ -568,8 +1088,16 @@ bool: ``True`` if numpy arrays are used, ``False`` otherwise.
 This can be changed any time. For any new request the new value is used
 when processing the value attribute.
 )");
+PyDoc_STRVAR(numpy_views__doc__, R"(numpy_views
+
+bool: If ``True`` array values of put requests are read-only numpy
+arrays using the memory of the request instead of copies.
+
+This is only used if :attr:`use_numpy` is ``True``. Defaults to ``False``.
+)");
 PyMemberDef pv_members[] = {
     {"use_numpy",  T_BOOL,   offsetof(Pv, use_numpy), 0, use_numpy__doc__},
+    {"numpy_views", T_BOOL,  offsetof(Pv, numpy_views), 0, numpy_views__doc__},
     {nullptr}
 };
 
@@ -590,7 +1118,9 @@ The following keys can occur in an attributes dictionary:
         Data value, type depends on the PV type. For integer types
         and enum types this is ``int``, for floating point types this
         is ``float``. For string types this is ``bytes``.
-        For arrays this is a sequence of the corresponding values.
+        For arrays this is a sequence of the corresponding values or
+        an object with a C-contiguous buffer (e.g. ``array.array``,
+        ``memoryview`` or ``bytes``), which is copied in bulk.
 
     status
         Value status, one of :class:`channel_access.common.Status`.
@@ -642,6 +1172,9 @@ The following keys can occur in an attributes dictionary:
         Typically the status becomes :class:`channel_access.common.Status.LOLO` or :class:`channel_access.common.Status.HIHI`.
         This is only used for numerical PVs.
 
+Everywhere an attributes dictionary is expected an :class:`Attributes`
+object can be used instead. It is converted much faster.
+
 Args:
     name (bytes): The cannocial name of the PV. If a server serves the
         same PV under different names (aliases), this should be the
@@ -721,5 +1254,95 @@ casPV* give_to_server(PyObject* obj) {
     return pv->proxy.get();
 }
 
+bool check_pv(PyObject* obj)
+{
+    switch (PyObject_IsInstance(obj, reinterpret_cast<PyObject*>(&pv_type))) {
+        case 1:
+            return true;
+        case 0:
+            PyErr_SetString(PyExc_TypeError, "Return value must be a PV instance");
+        default:
+            return false;
+    }
+}
+
+bool held_by_server(PyObject* obj)
+{
+    return reinterpret_cast<Pv*>(obj)->held_by_server;
+}
+
+bool prepare_event(PyObject* obj, PyObject* events, PyObject* attributes, PreparedEvent& event)
+{
+    switch (PyObject_IsInstance(obj, reinterpret_cast<PyObject*>(&pv_type))) {
+        case 1:
+            break;
+        case 0:
+            PyErr_SetString(PyExc_TypeError, "Events can only be posted for PV instances");
+        default:
+            return false;
+    }
+
+    return reinterpret_cast<Pv*>(obj)->proxy->prepareEvent(events, attributes, event);
+}
+
+bool post_events(std::vector<PreparedEvent>& events)
+{
+    bool success = true;
+    for (PreparedEvent& event : events) {
+        if (not event.values) continue;
+
+        try {
+            // Events are only prepared by PvProxy::prepareEvent()
+            static_cast<PvProxy*>(event.pv)->post(event.mask, *event.values);
+        } catch (...) {
+            success = false;
+        }
+        event.values->unreference();
+        event.values = nullptr;
+    }
+    return success;
+}
+
+void post_queued_event(casPV& pv, casEventMask const& mask, gdd& values)
+{
+    // Events are only queued by PvProxy::post()
+    static_cast<PvProxy&>(pv).postQueued(mask, values);
+}
+
+void release_events(std::vector<PreparedEvent>& events)
+{
+    for (PreparedEvent& event : events) {
+        if (event.values) {
+            event.values->unreference();
+            event.values = nullptr;
+        }
+    }
+}
+
+bool add_to_registry(PyObject* obj, std::shared_ptr<Registry> const& registry)
+{
+    switch (PyObject_IsInstance(obj, reinterpret_cast<PyObject*>(&pv_type))) {
+        case 1:
+            break;
+        case 0:
+            PyErr_SetString(PyExc_TypeError, "Argument must be a PV instance");
+        default:
+            return false;
+    }
+
+    Pv* pv = reinterpret_cast<Pv*>(obj);
+    if (not pv->name) {
+        PyErr_SetString(PyExc_RuntimeError, "PV is not initialized");
+        return false;
+    }
+
+    if (pv->registry and pv->registry != registry) {
+        pv->registry->remove(pv->name, obj);
+    }
+    pv->registry = registry;
+    registry->insert(pv->name, obj);
+    return true;
+}
+
 
 }
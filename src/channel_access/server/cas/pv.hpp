@@ -1,9 +1,12 @@
 #ifndef INCLUDE_GUARD_35A32778_12EC_461B_9182_2CD507FA46A3
 #define INCLUDE_GUARD_35A32778_12EC_461B_9182_2CD507FA46A3
 
+#include <memory>
+#include <vector>
 #include <Python.h>
+#include <casdef.h>
 
-class casPV;
+#include "registry.hpp"
 
 namespace cas {
 
@@ -24,6 +27,62 @@ void destroy_pv_type();
  */
 casPV* give_to_server(PyObject* obj);
 
+/**
+ * Return ``true`` if ``obj`` is a Python Pv object, otherwise set a TypeError.
+ */
+bool check_pv(PyObject* obj);
+
+/**
+ * Return ``true`` if the server currently holds the Python Pv object,
+ * i.e. it has open channels.
+ *
+ * ``obj`` must be a Pv instance.
+ */
+bool held_by_server(PyObject* obj);
+
+/**
+ * Register the Python Pv object in ``registry`` under its name.
+ *
+ * A Pv is registered in at most one registry, a former registration is removed.
+ * The Pv removes itself from the registry when it is deallocated.
+ */
+bool add_to_registry(PyObject* obj, std::shared_ptr<Registry> const& registry);
+
+/** Converted event of a Pv, ready to be posted without the GIL.
+ */
+struct PreparedEvent {
+    casPV* pv;
+    casEventMask mask;
+    gdd* values;
+};
+
+/**
+ * Convert ``events`` and ``attributes`` of the Python Pv object ``obj`` into ``event``.
+ *
+ * If the Pv is not installed into a server ``event.values`` is ``nullptr``
+ * and nothing has to be posted. The Pv object must be kept alive until the
+ * event is posted.
+ */
+bool prepare_event(PyObject* obj, PyObject* events, PyObject* attributes, PreparedEvent& event);
+
+/**
+ * Post the prepared events and release them. Does not need the GIL.
+ *
+ * Returns ``false`` if posting any of the events failed, all events are
+ * released anyway.
+ */
+bool post_events(std::vector<PreparedEvent>& events);
+
+/**
+ * Post an event taken from the event queue. Does not need the GIL.
+ */
+void post_queued_event(casPV& pv, casEventMask const& mask, gdd& values);
+
+/**
+ * Release prepared events without posting them. Does not need the GIL.
+ */
+void release_events(std::vector<PreparedEvent>& events);
+
 }
 
 #endif
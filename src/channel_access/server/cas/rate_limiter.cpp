@@ -0,0 +1,142 @@
+#include "rate_limiter.hpp"
+
+#include <fdManager.h>
+#include <gdd.h>
+
+#include "server_thread.hpp"
+
+namespace cas {
+
+EventRateLimiter::EventRateLimiter(casPV& pv)
+    : pv(pv), timer(fileDescriptorManager.createTimer()),
+      interval{0.0}, has_posted{false}, timer_started{false},
+      pending_values{nullptr}, conflated{0}, dropped{0}
+{
+}
+
+EventRateLimiter::~EventRateLimiter()
+{
+    // Waits for a running expire()
+    timer.destroy();
+    if (pending_values) {
+        pending_values->unreference();
+    }
+}
+
+void EventRateLimiter::setMaxRate(double rate)
+{
+    gdd* values = nullptr;
+    casEventMask mask;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        interval = rate > 0.0 ? 1.0 / rate : 0.0;
+        if (interval == 0.0) {
+            std::swap(values, pending_values);
+            mask = pending_mask;
+        }
+    }
+
+    if (values) {
+        timer.cancel();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            timer_started = false;
+        }
+        flush(values, mask);
+    }
+}
+
+double EventRateLimiter::maxRate() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return interval > 0.0 ? 1.0 / interval : 0.0;
+}
+
+void EventRateLimiter::post(casEventMask const& mask, gdd& values)
+{
+    bool post_now = false;
+    bool start_timer = false;
+    double delay = 0.0;
+    gdd* replaced = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        epicsTime const now = epicsTime::getCurrent();
+        if (interval == 0.0) {
+            post_now = true;
+        } else if (not pending_values and not timer_started and (not has_posted or now - last_post >= interval)) {
+            post_now = true;
+            last_post = now;
+            has_posted = true;
+        } else {
+            values.reference();
+            if (pending_values) {
+                replaced = pending_values;
+                pending_mask |= mask;
+                ++dropped;
+            } else {
+                pending_mask = mask;
+            }
+            pending_values = &values;
+            ++conflated;
+
+            if (not timer_started) {
+                timer_started = true;
+                start_timer = true;
+                delay = interval - (now - last_post);
+                if (delay < 0.0) delay = 0.0;
+            }
+        }
+    }
+
+    if (replaced) {
+        replaced->unreference();
+    }
+    if (start_timer) {
+        timer.start(*this, delay);
+        // The loop only recalculates its timeout when it wakes up
+        wake_process_thread();
+    }
+    if (post_now) {
+        pv.postEvent(mask, values);
+    }
+}
+
+void EventRateLimiter::statistics(std::uint64_t& conflated_events, std::uint64_t& dropped_values) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    conflated_events = conflated;
+    dropped_values = dropped;
+}
+
+epicsTimerNotify::expireStatus EventRateLimiter::expire(epicsTime const& current_time)
+{
+    gdd* values = nullptr;
+    casEventMask mask;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::swap(values, pending_values);
+        mask = pending_mask;
+        timer_started = false;
+        if (values) {
+            last_post = current_time;
+            has_posted = true;
+        }
+    }
+
+    flush(values, mask);
+    return noRestart;
+}
+
+void EventRateLimiter::flush(gdd* values, casEventMask const& mask)
+{
+    if (not values) return;
+
+    try {
+        pv.postEvent(mask, *values);
+    } catch (...) {
+        // Nobody to report to from the timer, the next event tries again
+    }
+    values->unreference();
+}
+
+}
@@ -0,0 +1,72 @@
+#ifndef INCLUDE_GUARD_4E7A2D19_C8B3_4F05_8A6E_D13B9F2C7E40
+#define INCLUDE_GUARD_4E7A2D19_C8B3_4F05_8A6E_D13B9F2C7E40
+
+#include <cstdint>
+#include <mutex>
+#include <casdef.h>
+#include <epicsTimer.h>
+
+namespace cas {
+
+/** Limits the rate of events posted for a PV.
+ *
+ * Events which arrive faster than the maximum rate are conflated: only
+ * the latest values are kept together with the union of the event masks
+ * and they are posted by a timer of the fdManager loop, i.e. from
+ * ``cas.process()``.
+ *
+ * All methods are thread-safe and do not need the GIL.
+ */
+class EventRateLimiter : public epicsTimerNotify {
+public:
+    explicit EventRateLimiter(casPV& pv);
+    ~EventRateLimiter();
+
+    EventRateLimiter(EventRateLimiter const&) = delete;
+    EventRateLimiter& operator=(EventRateLimiter const&) = delete;
+
+    /** Set the maximum number of events per second.
+     * ``0`` disables the limit, a conflated event is posted immediately.
+     */
+    void setMaxRate(double rate);
+
+    /** Return the maximum number of events per second, ``0`` if disabled.
+     */
+    double maxRate() const;
+
+    /** Post an event or conflate it with the pending one.
+     * ``values`` is referenced if it is conflated. Throws like
+     * ``casPV::postEvent()``.
+     */
+    void post(casEventMask const& mask, gdd& values);
+
+    /** Return the number of conflated events, i.e. events delayed by the
+     * limit, and the number of dropped values, i.e. delayed values which
+     * were replaced by newer ones before they were posted.
+     */
+    void statistics(std::uint64_t& conflated, std::uint64_t& dropped) const;
+
+private:
+    expireStatus expire(epicsTime const& current_time) override;
+
+    // Post the pending event, if any. Only call without the mutex held.
+    void flush(gdd* values, casEventMask const& mask);
+
+    casPV& pv;
+    epicsTimer& timer;
+
+    mutable std::mutex mutex;
+    // Minimum time between two events in seconds, 0 if disabled
+    double interval;
+    epicsTime last_post;
+    bool has_posted;
+    bool timer_started;
+    gdd* pending_values;
+    casEventMask pending_mask;
+    std::uint64_t conflated;
+    std::uint64_t dropped;
+};
+
+}
+
+#endif
@@ -0,0 +1,236 @@
+#include "registry.hpp"
+
+#include <cstring>
+
+namespace cas {
+namespace {
+
+// Must be a power of two
+constexpr std::size_t initial_capacity = 64;
+
+}
+
+std::uint64_t hash_name(char const* name, std::size_t length)
+{
+    // 64 bit FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(name[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+Registry::Registry()
+    : slots(initial_capacity), used{0}, deleted{0}
+{
+}
+
+std::size_t Registry::lookup(char const* name, std::size_t length, std::uint64_t hash) const
+{
+    std::size_t const mask = slots.size() - 1;
+    for (std::size_t i = hash & mask; ; i = (i + 1) & mask) {
+        Slot const& slot = slots[i];
+        switch (slot.state) {
+            case SlotState::empty:
+                return slots.size();
+            case SlotState::used:
+                if (slot.hash == hash and slot.name.size() == length
+                        and std::memcmp(slot.name.data(), name, length) == 0) {
+                    return i;
+                }
+                break;
+            case SlotState::deleted:
+                break;
+        }
+    }
+}
+
+void Registry::rehash(std::size_t capacity)
+{
+    std::vector<Slot> old_slots(capacity);
+    old_slots.swap(slots);
+    deleted = 0;
+
+    std::size_t const mask = slots.size() - 1;
+    for (Slot& old_slot : old_slots) {
+        if (old_slot.state != SlotState::used) continue;
+
+        std::size_t i = old_slot.hash & mask;
+        while (slots[i].state != SlotState::empty) {
+            i = (i + 1) & mask;
+        }
+        slots[i] = std::move(old_slot);
+    }
+}
+
+Registry::Slot& Registry::slotFor(char const* name, std::size_t length, std::uint64_t hash)
+{
+    std::size_t index = lookup(name, length, hash);
+    if (index != slots.size()) return slots[index];
+
+    // Keep the load factor (including tombstones) below 3/4
+    if ((used + deleted + 1) * 4 > slots.size() * 3) {
+        if ((used + 1) * 2 > slots.size()) {
+            rehash(slots.size() * 2);
+        } else {
+            rehash(slots.size());
+        }
+    }
+
+    std::size_t const mask = slots.size() - 1;
+    std::size_t i = hash & mask;
+    while (slots[i].state == SlotState::used) {
+        i = (i + 1) & mask;
+    }
+
+    Slot& slot = slots[i];
+    if (slot.state == SlotState::deleted) --deleted;
+    slot.state = SlotState::used;
+    slot.hash = hash;
+    slot.name.assign(name, length);
+    slot.pv = nullptr;
+    slot.alias_of.clear();
+    ++used;
+    return slot;
+}
+
+void Registry::release(std::size_t index)
+{
+    Slot& slot = slots[index];
+    if (slot.pv or not slot.alias_of.empty()) return;
+
+    slot.state = SlotState::deleted;
+    slot.name.clear();
+    --used;
+    ++deleted;
+}
+
+PyObject* Registry::resolve(char const* name) const
+{
+    std::size_t const length = std::strlen(name);
+    std::size_t index = lookup(name, length, hash_name(name, length));
+    if (index == slots.size()) return nullptr;
+
+    Slot const& slot = slots[index];
+    if (slot.pv or slot.alias_of.empty()) return slot.pv;
+
+    // Aliases are resolved once, the target must be a pv
+    std::string const& alias_of = slot.alias_of;
+    index = lookup(alias_of.data(), alias_of.size(), hash_name(alias_of.data(), alias_of.size()));
+    if (index == slots.size()) return nullptr;
+    return slots[index].pv;
+}
+
+void Registry::insert(char const* name, PyObject* pv)
+{
+    std::size_t const length = std::strlen(name);
+    std::uint64_t const hash = hash_name(name, length);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    slotFor(name, length, hash).pv = pv;
+}
+
+void Registry::remove(char const* name, PyObject* pv)
+{
+    std::size_t const length = std::strlen(name);
+    std::uint64_t const hash = hash_name(name, length);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::size_t index = lookup(name, length, hash);
+    if (index == slots.size() or slots[index].pv != pv) return;
+
+    slots[index].pv = nullptr;
+    release(index);
+}
+
+void Registry::insertAlias(char const* alias, char const* name)
+{
+    std::size_t const length = std::strlen(alias);
+    std::uint64_t const hash = hash_name(alias, length);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    slotFor(alias, length, hash).alias_of = name;
+}
+
+void Registry::insertAliases(std::vector<std::pair<std::string, std::string>> const& aliases)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // Grow once instead of rehashing repeatedly
+    std::size_t capacity = slots.size();
+    while ((used + aliases.size()) * 2 > capacity) {
+        capacity *= 2;
+    }
+    if (capacity != slots.size()) {
+        rehash(capacity);
+    }
+
+    for (auto const& alias : aliases) {
+        std::uint64_t const hash = hash_name(alias.first.data(), alias.first.size());
+        slotFor(alias.first.c_str(), alias.first.size(), hash).alias_of = alias.second;
+    }
+}
+
+bool Registry::removeAlias(char const* alias)
+{
+    std::size_t const length = std::strlen(alias);
+    std::uint64_t const hash = hash_name(alias, length);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::size_t index = lookup(alias, length, hash);
+    if (index == slots.size() or slots[index].alias_of.empty()) return false;
+
+    slots[index].alias_of.clear();
+    release(index);
+    return true;
+}
+
+bool Registry::resolveAlias(char const* alias, std::string& name) const
+{
+    std::size_t const length = std::strlen(alias);
+    std::uint64_t const hash = hash_name(alias, length);
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::size_t index = lookup(alias, length, hash);
+    if (index == slots.size() or slots[index].alias_of.empty()) return false;
+
+    name = slots[index].alias_of;
+    return true;
+}
+
+std::vector<std::pair<std::string, std::string>> Registry::aliases() const
+{
+    std::vector<std::pair<std::string, std::string>> result;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Slot const& slot : slots) {
+        if (slot.state == SlotState::used and not slot.alias_of.empty()) {
+            result.emplace_back(slot.name, slot.alias_of);
+        }
+    }
+    return result;
+}
+
+bool Registry::contains(char const* name) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return resolve(name) != nullptr;
+}
+
+PyObject* Registry::find(char const* name) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return resolve(name);
+}
+
+std::size_t Registry::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return used;
+}
+
+}
@@ -0,0 +1,114 @@
+#ifndef INCLUDE_GUARD_578CB251_272D_438A_BE9A_4CE3BD885CE4
+#define INCLUDE_GUARD_578CB251_272D_438A_BE9A_4CE3BD885CE4
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <Python.h>
+
+namespace cas {
+
+/** Hash function used for encoded PV names.
+ */
+std::uint64_t hash_name(char const* name, std::size_t length);
+
+/** Native name registry.
+ *
+ * Maps encoded PV names to Python Pv objects with an open addressing
+ * hash table. All methods are protected by an internal mutex, so the
+ * registry can be queried without holding the GIL.
+ *
+ * A name can also be an alias for another name. PVs take precedence
+ * over aliases with the same name and aliases are resolved only once,
+ * an alias for an alias does not resolve.
+ *
+ * The registry only stores borrowed references. Pv objects remove
+ * themselves when they are deallocated.
+ */
+class Registry {
+public:
+    Registry();
+
+    Registry(Registry const&) = delete;
+    Registry& operator=(Registry const&) = delete;
+
+    /** Insert ``pv`` under ``name``, replacing any existing entry.
+     */
+    void insert(char const* name, PyObject* pv);
+
+    /** Remove the entry for ``name`` if it still refers to ``pv``.
+     */
+    void remove(char const* name, PyObject* pv);
+
+    /** Make ``alias`` an alternative name for ``name``, replacing an
+     * existing alias.
+     */
+    void insertAlias(char const* alias, char const* name);
+
+    /** Insert many aliases at once. Each pair is ``(alias, name)``.
+     */
+    void insertAliases(std::vector<std::pair<std::string, std::string>> const& aliases);
+
+    /** Remove ``alias``. Return ``false`` if there is no such alias.
+     */
+    bool removeAlias(char const* alias);
+
+    /** Store the name ``alias`` refers to in ``name``.
+     * Return ``false`` if there is no such alias.
+     */
+    bool resolveAlias(char const* alias, std::string& name) const;
+
+    /** Return all ``(alias, name)`` pairs.
+     */
+    std::vector<std::pair<std::string, std::string>> aliases() const;
+
+    /** Return ``true`` if a Pv is registered for ``name`` or an alias
+     * named ``name`` refers to a registered Pv.
+     * Does not need the GIL.
+     */
+    bool contains(char const* name) const;
+
+    /** Return the Pv object for ``name`` or ``nullptr``, resolving aliases.
+     * Returns borrowed reference, the GIL must be held while using it.
+     */
+    PyObject* find(char const* name) const;
+
+    /** Return the number of registered names and aliases.
+     */
+    std::size_t size() const;
+
+private:
+    enum class SlotState : unsigned char { empty, used, deleted };
+
+    // A used slot has a pv, an alias target or both
+    struct Slot {
+        SlotState state = SlotState::empty;
+        std::uint64_t hash = 0;
+        std::string name;
+        PyObject* pv = nullptr;
+        std::string alias_of;
+    };
+
+    // only call with mutex held
+    std::size_t lookup(char const* name, std::size_t length, std::uint64_t hash) const;
+    // only call with mutex held, returns the existing or a new slot
+    Slot& slotFor(char const* name, std::size_t length, std::uint64_t hash);
+    // only call with mutex held, frees the slot if it is no longer used
+    void release(std::size_t index);
+    // only call with mutex held
+    PyObject* resolve(char const* name) const;
+    // only call with mutex held
+    void rehash(std::size_t capacity);
+
+    mutable std::mutex mutex;
+    std::vector<Slot> slots;
+    std::size_t used;
+    std::size_t deleted;
+};
+
+}
+
+#endif
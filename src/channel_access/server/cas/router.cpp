@@ -0,0 +1,242 @@
+#include "router.hpp"
+
+#include <cstring>
+#include <iterator>
+
+#include "pv.hpp"
+
+namespace cas {
+namespace {
+
+bool is_prefix_pattern(std::string const& pattern)
+{
+    if (pattern.empty()) return false;
+
+    std::size_t const wildcard = pattern.find_first_of("*?");
+    return wildcard == pattern.size() - 1 and pattern[wildcard] == '*';
+}
+
+}
+
+bool match_pattern(char const* pattern, char const* name)
+{
+    char const* star = nullptr;
+    char const* backtrack = nullptr;
+    while (*name) {
+        if (*pattern == '*') {
+            star = ++pattern;
+            backtrack = name;
+        } else if (*pattern == '?' or *pattern == *name) {
+            ++pattern;
+            ++name;
+        } else if (star) {
+            // Let the last star match one more character
+            pattern = star;
+            name = ++backtrack;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') ++pattern;
+    return *pattern == '\0';
+}
+
+Router::Router(std::size_t capacity)
+    : capacity{capacity}
+{
+}
+
+Router::Route const* Router::findRoute(char const* name) const
+{
+    for (Route const& route : routes) {
+        if (route.prefix) {
+            if (std::strncmp(route.pattern.c_str(), name, route.pattern.size() - 1) == 0) return &route;
+        } else {
+            if (match_pattern(route.pattern.c_str(), name)) return &route;
+        }
+    }
+    return nullptr;
+}
+
+void Router::evict(std::vector<PyObject*>& released, std::size_t keep)
+{
+    if (cache.size() <= capacity or lru.size() <= keep) return;
+
+    // Walk from the least recently used PV and skip PVs with open channels
+    LruList::iterator const stop = std::next(lru.begin(), keep);
+    LruList::iterator it = lru.end();
+    while (cache.size() > capacity and it != stop) {
+        --it;
+        if (held_by_server(it->second)) continue;
+
+        released.push_back(it->second);
+        cache.erase(it->first);
+        it = lru.erase(it);
+    }
+}
+
+void Router::add(char const* pattern, PyObject* factory)
+{
+    Py_INCREF(factory);
+    PyObject* old_factory = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (Route& route : routes) {
+            if (route.pattern == pattern) {
+                old_factory = route.factory;
+                route.factory = factory;
+                break;
+            }
+        }
+        if (not old_factory) {
+            routes.push_back(Route{pattern, false, factory});
+            routes.back().prefix = is_prefix_pattern(routes.back().pattern);
+        }
+    }
+    Py_XDECREF(old_factory);
+}
+
+bool Router::remove(char const* pattern)
+{
+    PyObject* factory = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = routes.begin(); it != routes.end(); ++it) {
+            if (it->pattern == pattern) {
+                factory = it->factory;
+                routes.erase(it);
+                break;
+            }
+        }
+    }
+    Py_XDECREF(factory);
+    return factory != nullptr;
+}
+
+bool Router::matches(char const* name) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return findRoute(name) != nullptr;
+}
+
+void Router::touch(char const* name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (cache.empty()) return;
+
+    auto it = cache.find(name);
+    if (it != cache.end()) {
+        lru.splice(lru.begin(), lru, it->second);
+    }
+}
+
+PyObject* Router::get(char const* name)
+{
+    PyObject* factory;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(name);
+        if (it != cache.end()) {
+            lru.splice(lru.begin(), lru, it->second);
+            PyObject* pv = it->second->second;
+            Py_INCREF(pv);
+            return pv;
+        }
+
+        Route const* route = findRoute(name);
+        if (not route) return nullptr;
+        factory = route->factory;
+        Py_INCREF(factory);
+    }
+
+    // The factory can release the GIL, the cache is checked again afterwards
+    PyObject* pv = PyObject_CallFunction(factory, "y", name);
+    Py_DECREF(factory);
+    if (not pv) return nullptr;
+    if (pv == Py_None) {
+        Py_DECREF(pv);
+        return nullptr;
+    }
+    if (not check_pv(pv)) {
+        Py_DECREF(pv);
+        return nullptr;
+    }
+
+    std::vector<PyObject*> released;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = cache.find(name);
+        if (it != cache.end()) {
+            // Created concurrently, use the cached PV
+            released.push_back(pv);
+            lru.splice(lru.begin(), lru, it->second);
+            pv = it->second->second;
+            Py_INCREF(pv);
+        } else {
+            Py_INCREF(pv);
+            lru.emplace_front(name, pv);
+            cache.emplace(name, lru.begin());
+            // The new PV is not given to the server yet
+            evict(released, 1);
+        }
+    }
+
+    for (PyObject* obj : released) {
+        Py_DECREF(obj);
+    }
+    return pv;
+}
+
+void Router::setCapacity(std::size_t capacity_)
+{
+    std::vector<PyObject*> released;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        capacity = capacity_;
+        evict(released, 0);
+    }
+
+    for (PyObject* obj : released) {
+        Py_DECREF(obj);
+    }
+}
+
+std::size_t Router::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return cache.size();
+}
+
+int Router::traverse(visitproc visit, void* arg)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (Route const& route : routes) {
+        Py_VISIT(route.factory);
+    }
+    for (auto const& entry : lru) {
+        Py_VISIT(entry.second);
+    }
+    return 0;
+}
+
+void Router::clear()
+{
+    std::vector<Route> old_routes;
+    LruList old_lru;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        old_routes.swap(routes);
+        old_lru.swap(lru);
+        cache.clear();
+    }
+
+    // Release outside of the lock, finalizers might use the router
+    for (Route const& route : old_routes) {
+        Py_DECREF(route.factory);
+    }
+    for (auto const& entry : old_lru) {
+        Py_DECREF(entry.second);
+    }
+}
+
+}
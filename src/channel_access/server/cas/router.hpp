@@ -0,0 +1,104 @@
+#ifndef INCLUDE_GUARD_D6E5D63E_39BD_4313_AE38_660860023349
+#define INCLUDE_GUARD_D6E5D63E_39BD_4313_AE38_660860023349
+
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <Python.h>
+
+namespace cas {
+
+/** Return ``true`` if ``name`` matches the glob ``pattern``.
+ * ``*`` matches any sequence of characters, ``?`` matches one character.
+ */
+bool match_pattern(char const* pattern, char const* name);
+
+/** Pattern router for lazily created PVs.
+ *
+ * Maps name patterns to Python factory callables. PVs created by a
+ * factory are kept in a LRU cache. When more than ``capacity`` PVs are
+ * cached the least recently used ones without open channels are released.
+ *
+ * ``matches()`` and ``size()`` do not need the GIL, all other methods
+ * must be called with the GIL held.
+ */
+class Router {
+public:
+    explicit Router(std::size_t capacity = 0);
+
+    Router(Router const&) = delete;
+    Router& operator=(Router const&) = delete;
+
+    /** Add a route, replacing an existing one with the same pattern.
+     * Routes are checked in the order they are added.
+     */
+    void add(char const* pattern, PyObject* factory);
+
+    /** Remove a route. Return ``false`` if there is no such route.
+     * Already created PVs stay in the cache until they are evicted.
+     */
+    bool remove(char const* pattern);
+
+    /** Return ``true`` if ``name`` matches a route.
+     * Does not need the GIL.
+     */
+    bool matches(char const* name) const;
+
+    /** Mark ``name`` as recently used if it is cached.
+     */
+    void touch(char const* name);
+
+    /** Return the PV for ``name``, calling the factory if it is not cached.
+     * Returns new reference, ``nullptr`` with an exception set on errors
+     * and ``nullptr`` without exception if there is no PV for ``name``.
+     */
+    PyObject* get(char const* name);
+
+    /** Change the maximum number of cached PVs.
+     */
+    void setCapacity(std::size_t capacity);
+
+    /** Return the number of cached PVs.
+     * Does not need the GIL.
+     */
+    std::size_t size() const;
+
+    /** Visit all Python objects, for the garbage collector.
+     */
+    int traverse(visitproc visit, void* arg);
+
+    /** Remove all routes and cached PVs.
+     */
+    void clear();
+
+private:
+    struct Route {
+        std::string pattern;
+        // Patterns which only end with a ``*`` are compared by prefix
+        bool prefix;
+        PyObject* factory;
+    };
+
+    typedef std::list<std::pair<std::string, PyObject*>> LruList;
+
+    // only call with mutex held
+    Route const* findRoute(char const* name) const;
+    // only call with mutex held, the GIL must be held too.
+    // The ``keep`` most recently used PVs are never evicted.
+    void evict(std::vector<PyObject*>& released, std::size_t keep);
+
+    mutable std::mutex mutex;
+    std::vector<Route> routes;
+    std::size_t capacity;
+    // Most recently used PV first
+    LruList lru;
+    std::unordered_map<std::string, LruList::iterator> cache;
+};
+
+}
+
+#endif
@@ -0,0 +1,153 @@
+#include "search_cache.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "registry.hpp"
+
+namespace cas {
+namespace {
+
+// Ten bits per name with seven hash functions give a false positive rate below 1%
+constexpr std::size_t bits_per_name = 10;
+
+std::size_t words_for_capacity(std::size_t capacity)
+{
+    return (capacity * bits_per_name + 63) / 64;
+}
+
+std::chrono::steady_clock::duration to_duration(double seconds)
+{
+    return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(seconds));
+}
+
+}
+
+constexpr unsigned SearchCache::hash_count;
+
+SearchCache::SearchCache(std::size_t capacity, double max_age)
+    : capacity{capacity}, max_age{to_duration(max_age)},
+      bits(words_for_capacity(capacity)), count{0}, created{std::chrono::steady_clock::now()},
+      current_generation{0}, hit_count{0}, miss_count{0}
+{
+}
+
+void SearchCache::configure(std::size_t capacity_, double max_age_)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    ++current_generation;
+    capacity = capacity_;
+    max_age = to_duration(max_age_);
+    bits.assign(words_for_capacity(capacity_), 0);
+    count = 0;
+    created = std::chrono::steady_clock::now();
+}
+
+bool SearchCache::enabled() const
+{
+    return capacity > 0;
+}
+
+void SearchCache::reset()
+{
+    if (count > 0) {
+        std::fill(bits.begin(), bits.end(), 0);
+        count = 0;
+    }
+    created = std::chrono::steady_clock::now();
+}
+
+bool SearchCache::expired() const
+{
+    return std::chrono::steady_clock::now() - created > max_age;
+}
+
+bool SearchCache::contains(char const* name)
+{
+    if (not enabled()) return false;
+
+    std::uint64_t const hash = hash_name(name, std::strlen(name));
+    // Double hashing: derive all bit positions from two 32 bit halves
+    std::uint64_t const h1 = hash & 0xffffffffu;
+    std::uint64_t const h2 = (hash >> 32) | 1;
+
+    bool found = true;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (count == 0 or bits.empty()) {
+            found = false;
+        } else if (expired()) {
+            reset();
+            found = false;
+        } else {
+            std::uint64_t const size = bits.size() * 64;
+            for (unsigned i = 0; i < hash_count; ++i) {
+                std::uint64_t const bit = (h1 + i * h2) % size;
+                if (not (bits[bit / 64] & (std::uint64_t{1} << (bit % 64)))) {
+                    found = false;
+                    break;
+                }
+            }
+        }
+    }
+
+    if (found) {
+        ++hit_count;
+    } else {
+        ++miss_count;
+    }
+    return found;
+}
+
+std::uint64_t SearchCache::generation() const
+{
+    return current_generation.load();
+}
+
+void SearchCache::insert(char const* name, std::uint64_t generation)
+{
+    if (not enabled()) return;
+
+    std::uint64_t const hash = hash_name(name, std::strlen(name));
+    std::uint64_t const h1 = hash & 0xffffffffu;
+    std::uint64_t const h2 = (hash >> 32) | 1;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (generation != current_generation.load() or bits.empty()) return;
+
+    if (count >= capacity or expired()) {
+        reset();
+    }
+
+    std::uint64_t const size = bits.size() * 64;
+    for (unsigned i = 0; i < hash_count; ++i) {
+        std::uint64_t const bit = (h1 + i * h2) % size;
+        bits[bit / 64] |= std::uint64_t{1} << (bit % 64);
+    }
+    ++count;
+}
+
+void SearchCache::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    ++current_generation;
+    reset();
+}
+
+std::size_t SearchCache::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return count;
+}
+
+unsigned long long SearchCache::hits() const
+{
+    return hit_count.load();
+}
+
+unsigned long long SearchCache::misses() const
+{
+    return miss_count.load();
+}
+
+}
@@ -0,0 +1,84 @@
+#ifndef INCLUDE_GUARD_0218A89D_2B3B_46A2_904B_77442864374A
+#define INCLUDE_GUARD_0218A89D_2B3B_46A2_904B_77442864374A
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace cas {
+
+/** Negative search cache.
+ *
+ * A Bloom filter remembering names which do not exist on this server.
+ * Names can only be added, the filter is cleared when it holds
+ * ``capacity`` names, when it is older than ``max_age`` seconds or
+ * when ``clear()`` is called. The age limit bounds the time a false
+ * positive can hide a name.
+ *
+ * All methods are thread-safe and do not need the GIL.
+ */
+class SearchCache {
+public:
+    /** A capacity of zero disables the cache.
+     */
+    explicit SearchCache(std::size_t capacity = 0, double max_age = 60.0);
+
+    SearchCache(SearchCache const&) = delete;
+    SearchCache& operator=(SearchCache const&) = delete;
+
+    /** Change capacity and maximum age. This clears the cache.
+     */
+    void configure(std::size_t capacity, double max_age);
+
+    bool enabled() const;
+
+    /** Return ``true`` if ``name`` is (probably) not on this server.
+     * Updates the hit and miss counters.
+     */
+    bool contains(char const* name);
+
+    /** Return the current generation.
+     * Read it before deciding that a name does not exist and pass it to
+     * ``insert()``, so that a concurrent ``clear()`` is not lost.
+     */
+    std::uint64_t generation() const;
+
+    /** Remember that ``name`` does not exist.
+     * Nothing is inserted if the cache was cleared since ``generation``.
+     */
+    void insert(char const* name, std::uint64_t generation);
+
+    /** Forget all names.
+     */
+    void clear();
+
+    std::size_t size() const;
+    unsigned long long hits() const;
+    unsigned long long misses() const;
+
+private:
+    // only call with mutex held
+    void reset();
+    // only call with mutex held
+    bool expired() const;
+
+    static constexpr unsigned hash_count = 7;
+
+    mutable std::mutex mutex;
+    std::atomic<std::size_t> capacity;
+    std::chrono::steady_clock::duration max_age;
+    std::vector<std::uint64_t> bits;
+    std::size_t count;
+    std::chrono::steady_clock::time_point created;
+    std::atomic<std::uint64_t> current_generation;
+
+    std::atomic<unsigned long long> hit_count;
+    std::atomic<unsigned long long> miss_count;
+};
+
+}
+
+#endif
@@ -1,16 +1,114 @@
 #include "server.hpp"
 
+#include <fstream>
 #include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 #include <Python.h>
 #include <structmember.h>
 #include <casdef.h>
+#include <cadef.h>
 
 #include "cas.hpp"
 #include "convert.hpp"
+#include "async.hpp"
+#include "frame_publisher.hpp"
+#include "pv.hpp"
+#include "registry.hpp"
+#include "router.hpp"
+#include "search_cache.hpp"
+#include "shard_map.hpp"
 
 namespace cas {
 namespace {
 
+/** Return ``false`` if ``fn`` can not be called with ``count``
+ * positional arguments.
+ *
+ * Overrides of pvExistTest() and pvAttach() written before the context
+ * argument was added take one argument less. The arguments are bound
+ * with ``inspect.signature()`` so that partial objects, methods with
+ * default arguments and callable objects are handled too. Callables
+ * without a signature are assumed to accept the new signature.
+ */
+bool accepts_arguments(PyObject* fn, Py_ssize_t count)
+{
+    PyObject* inspect = PyImport_ImportModule("inspect");
+    PyObject* signature = inspect ? PyObject_CallMethod(inspect, "signature", "O", fn) : nullptr;
+    Py_XDECREF(inspect);
+    if (not signature) {
+        PyErr_Clear();
+        return true;
+    }
+
+    bool accepts = true;
+    PyObject* bind = PyObject_GetAttrString(signature, "bind");
+    PyObject* arguments = PyTuple_New(count);
+    if (bind and arguments) {
+        for (Py_ssize_t i = 0; i < count; ++i) {
+            Py_INCREF(Py_None);
+            PyTuple_SET_ITEM(arguments, i, Py_None);
+        }
+        PyObject* bound = PyObject_Call(bind, arguments, nullptr);
+        if (not bound and PyErr_ExceptionMatches(PyExc_TypeError)) {
+            accepts = false;
+        }
+        Py_XDECREF(bound);
+    }
+    Py_XDECREF(arguments);
+    Py_XDECREF(bind);
+    Py_DECREF(signature);
+    PyErr_Clear();
+    return accepts;
+}
+
+/** Remembers whether a hook like pvExistTest() accepts ``count``
+ * arguments.
+ *
+ * Binding a signature is slow, it is only done again when the function
+ * behind the hook changes. Needs the GIL.
+ */
+class CallConvention {
+public:
+    explicit CallConvention(Py_ssize_t count)
+        : count{count}, callable{nullptr}, accepts{true}
+    {}
+
+    CallConvention(CallConvention const&) = delete;
+    CallConvention& operator=(CallConvention const&) = delete;
+
+    bool acceptsArguments(PyObject* fn)
+    {
+        // Bound methods are created for every lookup
+        PyObject* key = PyMethod_Check(fn) ? PyMethod_GET_FUNCTION(fn) : fn;
+        if (key != callable) {
+            accepts = accepts_arguments(fn, count);
+            Py_INCREF(key);
+            Py_XDECREF(callable);
+            callable = key;
+        }
+        return accepts;
+    }
+
+    int traverse(visitproc visit, void* arg)
+    {
+        Py_VISIT(callable);
+        return 0;
+    }
+
+    void clear()
+    {
+        Py_CLEAR(callable);
+    }
+
+private:
+    Py_ssize_t const count;
+    PyObject* callable;
+    bool accepts;
+};
+
 class ServerProxy;
 struct Server {
     PyObject_HEAD
@@ -22,23 +120,68 @@ static_assert(std::is_standard_layout<Server>::value, "Server has to be standard
 class ServerProxy : public caServer {
 public:
     ServerProxy(PyObject* server)
-        : server{server}
+        : server{server}, registry{std::make_shared<Registry>()}, frame_publisher{server},
+          exist_convention{3}, attach_convention{2}
     {
         // No GIL, don't use the python API
+
+        // The event masks are fixed after construction, combine them once
+        for (unsigned events = 0; events < event_mask_count; ++events) {
+            casEventMask& mask = event_masks[events];
+            if (events & DBE_VALUE) {
+                mask |= valueEventMask();
+            }
+            if (events & DBE_ARCHIVE) {
+                mask |= logEventMask();
+            }
+            if (events & DBE_ALARM) {
+                mask |= alarmEventMask();
+            }
+            if (events & DBE_PROPERTY) {
+                mask |= propertyEventMask();
+            }
+        }
+    }
+
+    // Does not need the GIL
+    casEventMask eventMask(unsigned events) const
+    {
+        return event_masks[events % event_mask_count];
     }
 
     virtual pvExistReturn pvExistTest(casCtx const& ctx,
         caNetAddr const& clientAddress, char const* pPVAliasName) override
     {
+        // Registered names are answered without the GIL
+        if (registry->contains(pPVAliasName)) {
+            return pverExistsHere;
+        }
+        if (router.matches(pPVAliasName)) {
+            return pverExistsHere;
+        }
+        // Names served by the exist handler must not be sharded away,
+        // only names known not to be here are redirected
+        if (search_cache.contains(pPVAliasName)) {
+            return shardRedirect(pPVAliasName);
+        }
+        std::uint64_t const cache_generation = search_cache.generation();
+
         auto address = static_cast<sockaddr_in>(clientAddress);
         unsigned long host = ntohl(address.sin_addr.s_addr);
         unsigned short port = ntohs(address.sin_port);
 
         pvExistReturn ret = pverDoesNotExistHere;
+        bool converted = false;
         PyGILState_STATE gstate = PyGILState_Ensure();
             PyObject* fn = PyObject_GetAttrString(server, "pvExistTest");
             if (fn) {
-                PyObject* result = PyObject_CallFunction(fn, "(kH)y", host, port, pPVAliasName);
+                PyObject* result;
+                if (exist_convention.acceptsArguments(fn)) {
+                    result = PyObject_CallFunction(fn, "(kH)yN", host, port, pPVAliasName,
+                        create_async_context(ctx, nullptr, aitEnumInvalid));
+                } else {
+                    result = PyObject_CallFunction(fn, "(kH)y", host, port, pPVAliasName);
+                }
                 if (PyErr_Occurred()) {
                     PyErr_WriteUnraisable(fn);
                     PyErr_Clear();
@@ -46,7 +189,11 @@ public:
                 Py_DECREF(fn);
 
                 if (result) {
-                    to_exist_return(result, ret);
+                    if (give_async_exist_to_server(result)) {
+                        ret = pverAsyncCompletion;
+                    } else {
+                        converted = to_exist_return(result, ret);
+                    }
                     Py_DECREF(result);
                 }
             }
@@ -56,15 +203,34 @@ public:
                 PyErr_Clear();
             }
         PyGILState_Release(gstate);
+
+        // Only cache and redirect real answers, not errors
+        if (converted and ret.getStatus() == pverDoesNotExistHere) {
+            search_cache.insert(pPVAliasName, cache_generation);
+            return shardRedirect(pPVAliasName);
+        }
         return ret;
     }
 
+    // Redirect to the backend server of a name which is not here.
+    // Does not need the GIL.
+    pvExistReturn shardRedirect(char const* pv_name) const
+    {
+        Endpoint endpoint;
+        if (not shard_map.lookup(pv_name, endpoint)) return pverDoesNotExistHere;
+
+        caNetAddr addr;
+        addr.setSockIP(htonl(endpoint.host), htons(endpoint.port));
+        return pvExistReturn{addr};
+    }
+
     static PyObject* pvExistTest(PyObject* self, PyObject* args)
     {
         unsigned long host;
         unsigned short port;
         char const* pv_name;
-        if (not PyArg_ParseTuple(args, "(kH)y:pvExistTest", &host, &port, &pv_name)) return nullptr;
+        PyObject* context;
+        if (not PyArg_ParseTuple(args, "(kH)yO:pvExistTest", &host, &port, &pv_name, &context)) return nullptr;
 
         return PyObject_GetAttrString(cas::enum_exists, "NOT_EXISTS_HERE");
     }
@@ -74,18 +240,44 @@ public:
     {
         pvAttachReturn ret = S_casApp_pvNotFound;
         PyGILState_STATE gstate = PyGILState_Ensure();
-            PyObject* fn = PyObject_GetAttrString(server, "pvAttach");
-            if (fn) {
-                PyObject* result = PyObject_CallFunction(fn, "y", pPVAliasName);
-                if (PyErr_Occurred()) {
-                    PyErr_WriteUnraisable(fn);
-                    PyErr_Clear();
+            // A Pv with a reference count of zero is currently deallocated
+            PyObject* pv = registry->find(pPVAliasName);
+            if (pv and Py_REFCNT(pv) > 0) {
+                casPV* cas_pv = give_to_server(pv);
+                if (cas_pv) {
+                    ret = pvAttachReturn{*cas_pv};
                 }
-                Py_DECREF(fn);
+                router.touch(pPVAliasName);
+            } else if ((pv = router.get(pPVAliasName))) {
+                casPV* cas_pv = give_to_server(pv);
+                if (cas_pv) {
+                    ret = pvAttachReturn{*cas_pv};
+                }
+                Py_DECREF(pv);
+            } else if (not PyErr_Occurred()) {
+                PyObject* fn = PyObject_GetAttrString(server, "pvAttach");
+                if (fn) {
+                    PyObject* result;
+                    if (attach_convention.acceptsArguments(fn)) {
+                        result = PyObject_CallFunction(fn, "yN", pPVAliasName,
+                            create_async_context(ctx, nullptr, aitEnumInvalid));
+                    } else {
+                        result = PyObject_CallFunction(fn, "y", pPVAliasName);
+                    }
+                    if (PyErr_Occurred()) {
+                        PyErr_WriteUnraisable(fn);
+                        PyErr_Clear();
+                    }
+                    Py_DECREF(fn);
 
-                if (result) {
-                    to_attach_return(result, ret);
-                    Py_DECREF(result);
+                    if (result) {
+                        if (give_async_attach_to_server(result)) {
+                            ret = pvAttachReturn{S_casApp_asyncCompletion};
+                        } else {
+                            to_attach_return(result, ret);
+                        }
+                        Py_DECREF(result);
+                    }
                 }
             }
 
@@ -100,25 +292,471 @@ public:
     static PyObject* pvAttach(PyObject* self, PyObject* args)
     {
         char const* pv_name;
-        if (not PyArg_ParseTuple(args, "y:pvAttach", &pv_name)) return nullptr;
+        PyObject* context;
+        if (not PyArg_ParseTuple(args, "yO:pvAttach", &pv_name, &context)) return nullptr;
 
         return PyObject_GetAttrString(cas::enum_attach, "NOT_FOUND");
     }
 
+    static PyObject* registerPV(PyObject* self, PyObject* args)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        PyObject* pv;
+        if (not PyArg_ParseTuple(args, "O:registerPV", &pv)) return nullptr;
+
+        if (not add_to_registry(pv, proxy->registry)) return nullptr;
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* addAlias(PyObject* self, PyObject* args)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        char const* alias;
+        char const* pv_name;
+        if (not PyArg_ParseTuple(args, "yy:addAlias", &alias, &pv_name)) return nullptr;
+
+        Py_BEGIN_ALLOW_THREADS
+            proxy->registry->insertAlias(alias, pv_name);
+            // Names previously reported as missing might exist now
+            proxy->search_cache.clear();
+        Py_END_ALLOW_THREADS
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* addAliases(PyObject* self, PyObject* args)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        PyObject* mapping;
+        if (not PyArg_ParseTuple(args, "O:addAliases", &mapping)) return nullptr;
+
+        // Accept a dictionary or an iterable of (alias, name) pairs
+        PyObject* items = PyDict_Check(mapping) ? PyDict_Items(mapping) : PySequence_List(mapping);
+        if (not items) return nullptr;
+
+        std::vector<std::pair<std::string, std::string>> aliases;
+        aliases.reserve(PyList_GET_SIZE(items));
+        for (Py_ssize_t i = 0; i < PyList_GET_SIZE(items); ++i) {
+            char const* alias;
+            char const* pv_name;
+            if (not PyArg_ParseTuple(PyList_GET_ITEM(items, i), "yy:addAliases", &alias, &pv_name)) {
+                Py_DECREF(items);
+                return nullptr;
+            }
+            aliases.emplace_back(alias, pv_name);
+        }
+        Py_DECREF(items);
+
+        Py_BEGIN_ALLOW_THREADS
+            proxy->registry->insertAliases(aliases);
+            proxy->search_cache.clear();
+        Py_END_ALLOW_THREADS
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* loadAliases(PyObject* self, PyObject* args)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        PyObject* path;
+        if (not PyArg_ParseTuple(args, "O&:loadAliases", PyUnicode_FSConverter, &path)) return nullptr;
+
+        std::vector<std::pair<std::string, std::string>> aliases;
+        bool opened = false;
+        std::size_t bad_line = 0;
+        Py_BEGIN_ALLOW_THREADS
+            std::ifstream file(PyBytes_AS_STRING(path));
+            opened = file.is_open();
+
+            std::string line;
+            for (std::size_t line_number = 1; opened and std::getline(file, line); ++line_number) {
+                std::istringstream fields(line);
+                std::string alias, pv_name, rest;
+                if (not (fields >> alias) or alias[0] == '#') continue;
+
+                if (not (fields >> pv_name) or (fields >> rest and rest[0] != '#')) {
+                    bad_line = line_number;
+                    break;
+                }
+                aliases.emplace_back(std::move(alias), std::move(pv_name));
+            }
+
+            if (opened and not bad_line) {
+                proxy->registry->insertAliases(aliases);
+                proxy->search_cache.clear();
+            }
+        Py_END_ALLOW_THREADS
+
+        if (not opened) {
+            PyErr_Format(PyExc_OSError, "Could not open alias file %s", PyBytes_AS_STRING(path));
+            Py_DECREF(path);
+            return nullptr;
+        }
+        if (bad_line) {
+            PyErr_Format(PyExc_ValueError, "%s:%zu: expected 'alias name'", PyBytes_AS_STRING(path), bad_line);
+            Py_DECREF(path);
+            return nullptr;
+        }
+        Py_DECREF(path);
+        return PyLong_FromSize_t(aliases.size());
+    }
+
+    static PyObject* removeAlias(PyObject* self, PyObject* args)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        char const* alias;
+        if (not PyArg_ParseTuple(args, "y:removeAlias", &alias)) return nullptr;
+
+        return PyBool_FromLong(proxy->registry->removeAlias(alias));
+    }
+
+    static PyObject* resolveAlias(PyObject* self, PyObject* args)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        char const* alias;
+        if (not PyArg_ParseTuple(args, "y:resolveAlias", &alias)) return nullptr;
+
+        std::string pv_name;
+        if (not proxy->registry->resolveAlias(alias, pv_name)) Py_RETURN_NONE;
+        return PyBytes_FromStringAndSize(pv_name.data(), pv_name.size());
+    }
+
+    static PyObject* aliases(PyObject* self, PyObject*)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        std::vector<std::pair<std::string, std::string>> aliases;
+        Py_BEGIN_ALLOW_THREADS
+            aliases = proxy->registry->aliases();
+        Py_END_ALLOW_THREADS
+
+        PyObject* result = PyDict_New();
+        if (not result) return nullptr;
+
+        for (auto const& alias : aliases) {
+            PyObject* key = PyBytes_FromStringAndSize(alias.first.data(), alias.first.size());
+            PyObject* value = PyBytes_FromStringAndSize(alias.second.data(), alias.second.size());
+            if (not key or not value or PyDict_SetItem(result, key, value) < 0) {
+                Py_XDECREF(key);
+                Py_XDECREF(value);
+                Py_DECREF(result);
+                return nullptr;
+            }
+            Py_DECREF(key);
+            Py_DECREF(value);
+        }
+        return result;
+    }
+
+    static PyObject* clearSearchCache(PyObject* self, PyObject*)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        Py_BEGIN_ALLOW_THREADS
+            proxy->search_cache.clear();
+        Py_END_ALLOW_THREADS
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* postEvents(PyObject* self, PyObject* entries)
+    {
+        PyObject* sequence = PySequence_Fast(entries, "Argument must be a sequence of (pv, events, attributes) tuples");
+        if (not sequence) return nullptr;
+
+        Py_ssize_t const size = PySequence_Fast_GET_SIZE(sequence);
+        std::vector<PreparedEvent> events(size);
+
+        // Convert everything first, the sequence keeps the PVs alive
+        for (Py_ssize_t i = 0; i < size; ++i) {
+            PyObject* pv, *py_events, *attributes;
+            PyObject* item = PySequence_Fast_GET_ITEM(sequence, i);
+            if (not PyArg_ParseTuple(item, "OOO;Entries must be (pv, events, attributes) tuples", &pv, &py_events, &attributes)
+                    or not prepare_event(pv, py_events, attributes, events[i])) {
+                events.resize(i);
+                Py_BEGIN_ALLOW_THREADS
+                    release_events(events);
+                Py_END_ALLOW_THREADS
+                Py_DECREF(sequence);
+                return nullptr;
+            }
+        }
+
+        bool success;
+        Py_BEGIN_ALLOW_THREADS
+            success = post_events(events);
+        Py_END_ALLOW_THREADS
+        Py_DECREF(sequence);
+
+        if (not success) {
+            PyErr_SetString(PyExc_RuntimeError, "Could not post events");
+            return nullptr;
+        }
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* publishFrame(PyObject* self, PyObject* pvs)
+    {
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* setPublishRate(PyObject* self, PyObject* arg)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        double const rate = PyFloat_AsDouble(arg);
+        if (rate == -1.0 and PyErr_Occurred()) return nullptr;
+        if (rate < 0.0) {
+            PyErr_SetString(PyExc_ValueError, "Publish rate must not be negative");
+            return nullptr;
+        }
+
+        proxy->frame_publisher.setRate(rate);
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* publishRate(PyObject* self, PyObject*)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        return PyFloat_FromDouble(proxy->frame_publisher.rate());
+    }
+
+    static PyObject* markDirty(PyObject* self, PyObject* pv)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        return PyBool_FromLong(proxy->frame_publisher.markDirty(pv));
+    }
+
+    static PyObject* frameCount(PyObject* self, PyObject*)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        return PyLong_FromUnsignedLongLong(proxy->frame_publisher.frames());
+    }
+
+    static PyObject* searchCacheStatistics(PyObject* self, PyObject*)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        return Py_BuildValue("{sKsKsn}",
+            "hits", proxy->search_cache.hits(),
+            "misses", proxy->search_cache.misses(),
+            "size", static_cast<Py_ssize_t>(proxy->search_cache.size()));
+    }
+
+    void configureSearchCache(std::size_t capacity, double max_age)
+    {
+        search_cache.configure(capacity, max_age);
+    }
+
+    static PyObject* addRoute(PyObject* self, PyObject* args)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        char const* pattern;
+        PyObject* factory;
+        if (not PyArg_ParseTuple(args, "yO:addRoute", &pattern, &factory)) return nullptr;
+
+        if (not PyCallable_Check(factory)) {
+            PyErr_SetString(PyExc_TypeError, "factory must be callable");
+            return nullptr;
+        }
+
+        proxy->router.add(pattern, factory);
+        // Names previously reported as missing might exist now
+        proxy->search_cache.clear();
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* removeRoute(PyObject* self, PyObject* args)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        char const* pattern;
+        if (not PyArg_ParseTuple(args, "y:removeRoute", &pattern)) return nullptr;
+
+        return PyBool_FromLong(proxy->router.remove(pattern));
+    }
+
+    static PyObject* routeCacheSize(PyObject* self, PyObject*)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        return PyLong_FromSize_t(proxy->router.size());
+    }
+
+    void configureRouteCache(std::size_t capacity)
+    {
+        router.setCapacity(capacity);
+    }
+
+    static PyObject* addShard(PyObject* self, PyObject* args, PyObject* kwds)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        static char const* keywords[] = {"address", "weight", nullptr};
+        unsigned long host;
+        unsigned short port;
+        unsigned int weight = 1;
+        if (not PyArg_ParseTupleAndKeywords(args, kwds, "(kH)|I:addShard", const_cast<char**>(keywords),
+                &host, &port, &weight)) return nullptr;
+
+        if (weight == 0) {
+            PyErr_SetString(PyExc_ValueError, "weight must be positive");
+            return nullptr;
+        }
+
+        Endpoint endpoint{static_cast<std::uint32_t>(host), port};
+        Py_BEGIN_ALLOW_THREADS
+            proxy->shard_map.addShard(endpoint, weight);
+        Py_END_ALLOW_THREADS
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* removeShard(PyObject* self, PyObject* args)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        unsigned long host;
+        unsigned short port;
+        if (not PyArg_ParseTuple(args, "(kH):removeShard", &host, &port)) return nullptr;
+
+        Endpoint endpoint{static_cast<std::uint32_t>(host), port};
+        bool removed;
+        Py_BEGIN_ALLOW_THREADS
+            removed = proxy->shard_map.removeShard(endpoint);
+        Py_END_ALLOW_THREADS
+        return PyBool_FromLong(removed);
+    }
+
+    static PyObject* addShardPrefix(PyObject* self, PyObject* args)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        char const* prefix;
+        unsigned long host;
+        unsigned short port;
+        if (not PyArg_ParseTuple(args, "y(kH):addShardPrefix", &prefix, &host, &port)) return nullptr;
+
+        proxy->shard_map.addPrefix(prefix, Endpoint{static_cast<std::uint32_t>(host), port});
+        Py_RETURN_NONE;
+    }
+
+    static PyObject* removeShardPrefix(PyObject* self, PyObject* args)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        char const* prefix;
+        if (not PyArg_ParseTuple(args, "y:removeShardPrefix", &prefix)) return nullptr;
+
+        return PyBool_FromLong(proxy->shard_map.removePrefix(prefix));
+    }
+
+    static PyObject* shardFor(PyObject* self, PyObject* args)
+    {
+        ServerProxy* proxy = reinterpret_cast<Server*>(self)->proxy.get();
+
+        char const* pv_name;
+        if (not PyArg_ParseTuple(args, "y:shardFor", &pv_name)) return nullptr;
+
+        Endpoint endpoint;
+        if (not proxy->shard_map.lookup(pv_name, endpoint)) Py_RETURN_NONE;
+        return Py_BuildValue("(kH)", static_cast<unsigned long>(endpoint.host), endpoint.port);
+    }
+
+    int traverse(visitproc visit, void* arg)
+    {
+        if (int ret = router.traverse(visit, arg)) return ret;
+        if (int ret = frame_publisher.traverse(visit, arg)) return ret;
+        if (int ret = exist_convention.traverse(visit, arg)) return ret;
+        return attach_convention.traverse(visit, arg);
+    }
+
+    void clear()
+    {
+        router.clear();
+        frame_publisher.clear();
+        exist_convention.clear();
+        attach_convention.clear();
+    }
+
 private:
+    // One mask for every combination of the DBE_* bits
+    static constexpr unsigned event_mask_count = 16;
+
     PyObject* server;
+    casEventMask event_masks[event_mask_count];
+    std::shared_ptr<Registry> registry;
+    SearchCache search_cache;
+    Router router;
+    ShardMap shard_map;
+    FramePublisher frame_publisher;
+    // Whether pvExistTest() and pvAttach() take the context argument
+    CallConvention exist_convention;
+    CallConvention attach_convention;
 };
 
+constexpr unsigned ServerProxy::event_mask_count;
+
 
 
 int server_init(PyObject* self, PyObject* args, PyObject* kwds)
 {
+    Server* server = reinterpret_cast<Server*>(self);
+
+    static char const* keywords[] = {"search_cache", "search_cache_age", "route_cache", nullptr};
+    Py_ssize_t search_cache = 0;
+    double search_cache_age = 60.0;
+    Py_ssize_t route_cache = 1000;
+    if (not PyArg_ParseTupleAndKeywords(args, kwds, "|ndn:Server", const_cast<char**>(keywords),
+            &search_cache, &search_cache_age, &route_cache)) return -1;
+
+    if (search_cache < 0) {
+        PyErr_SetString(PyExc_ValueError, "search_cache must not be negative");
+        return -1;
+    }
+    if (route_cache < 0) {
+        PyErr_SetString(PyExc_ValueError, "route_cache must not be negative");
+        return -1;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+        server->proxy->configureSearchCache(search_cache, search_cache_age);
+    Py_END_ALLOW_THREADS
+    // Eviction releases Python objects, keep the GIL
+    server->proxy->configureRouteCache(route_cache);
+    return 0;
+}
+
+int server_traverse(PyObject* self, visitproc visit, void* arg)
+{
+    Server* server = reinterpret_cast<Server*>(self);
+    if (server->proxy) {
+        return server->proxy->traverse(visit, arg);
+    }
+    return 0;
+}
+
+int server_clear(PyObject* self)
+{
+    Server* server = reinterpret_cast<Server*>(self);
+    if (server->proxy) {
+        server->proxy->clear();
+    }
     return 0;
 }
 
 void server_dealloc(PyObject* self)
 {
     Server* server = reinterpret_cast<Server*>(self);
+    PyObject_GC_UnTrack(self);
+    // Routes and cached PVs are python objects, release them with the GIL
+    server_clear(self);
     Py_BEGIN_ALLOW_THREADS
         server->proxy.reset();
     Py_END_ALLOW_THREADS
@@ -150,7 +788,7 @@ PyObject* server_new(PyTypeObject* type, PyObject* args, PyObject* kwds)
     return self;
 }
 
-PyDoc_STRVAR(pvExistTest__doc__, R"(pvExistTest(address, name)
+PyDoc_STRVAR(pvExistTest__doc__, R"(pvExistTest(address, name, context)
 
 Return wether/where the PV ``name`` exists.
 
@@ -161,12 +799,18 @@ Args:
     address (tuple): A tuple ``(ip, port)`` which identifies a client.
         The client IP address is encoded as a 32bit integer.
     name (bytes): The name of the requested PV.
+    context: A context object needed to create an :class:`AsyncPVExist` object.
 
 Returns:
-    An :class:`ExistsResponse` value indicating the search result or a
-    tuple ``(ip, port)`` indicating a server where the PV exists.
+    An :class:`ExistsResponse` value indicating the search result, a
+    bool, a tuple ``(ip, port)`` indicating a server where the PV exists
+    or an :class:`AsyncPVExist` object to signal an asynchronous exist test.
+    Other values raise a :class:`TypeError`.
+
+Overrides without the ``context`` parameter are still supported, they
+can't signal an asynchronous exist test.
 )");
-PyDoc_STRVAR(pvAttach__doc__, R"(pvAttach(name)
+PyDoc_STRVAR(pvAttach__doc__, R"(pvAttach(name, context)
 
 Return a PV handler object for ``name``.
 
@@ -178,15 +822,324 @@ a reference to it as long as it is needed.
 
 Args:
     name (bytes): The name of the requested PV.
+    context: A context object needed to create an :class:`AsyncPVAttach` object.
 
 Returns:
     An :class:`AttachResponse` value indicating the reason why a handler object
-    could not be created or a :class:`PV` instance for the requested PV.
+    could not be created, a :class:`PV` instance for the requested PV or
+    an :class:`AsyncPVAttach` object to signal an asynchronous attach.
+
+Overrides without the ``context`` parameter are still supported, they
+can't signal an asynchronous attach.
+)");
+
+PyDoc_STRVAR(registerPV__doc__, R"(registerPV(pv)
+
+Register a :class:`PV` instance under its name.
+
+Search and attach requests for registered names are answered directly
+without calling :meth:`pvExistTest` or :meth:`pvAttach`. Registering
+another PV with the same name replaces the entry. The server does not
+hold a reference, the entry is removed when the PV is deallocated.
+
+A PV can only be registered with one server at a time.
+
+This method is thread-safe.
+
+Args:
+    pv (:class:`PV`): The PV to register.
+)");
+
+PyDoc_STRVAR(addAlias__doc__, R"(addAlias(alias, name)
+
+Make ``alias`` an alternative name for the PV registered as ``name``.
+
+Aliases are resolved together with the names registered with
+:meth:`registerPV`, a registered PV with the same name as an alias takes
+precedence. Aliases for aliases are not resolved. Adding an existing
+alias replaces it.
+
+This method is thread-safe.
+
+Args:
+    alias (bytes): The alternative name.
+    name (bytes): The name of the PV.
+)");
+PyDoc_STRVAR(addAliases__doc__, R"(addAliases(aliases)
+
+Add many aliases at once, see :meth:`addAlias`.
+
+This method is thread-safe.
+
+Args:
+    aliases: A dictionary mapping aliases to names or an iterable
+        of ``(alias, name)`` tuples. All names are bytes.
+)");
+PyDoc_STRVAR(loadAliases__doc__, R"(loadAliases(path)
+
+Add aliases from a file, see :meth:`addAlias`.
+
+Each line contains an alias and a name separated by whitespace.
+Empty lines and lines starting with ``#`` are ignored. The names are
+used as they are, without decoding. Nothing is added if the file
+contains an invalid line.
+
+This method is thread-safe.
+
+Args:
+    path (str): Path of the alias file.
+
+Returns:
+    int: The number of aliases read.
+)");
+PyDoc_STRVAR(removeAlias__doc__, R"(removeAlias(alias)
+
+Remove an alias.
+
+This method is thread-safe.
+
+Args:
+    alias (bytes): The alternative name.
+
+Returns:
+    bool: ``False`` if there is no such alias.
+)");
+PyDoc_STRVAR(resolveAlias__doc__, R"(resolveAlias(alias)
+
+Return the name ``alias`` refers to or ``None``.
+
+This method is thread-safe.
+
+Args:
+    alias (bytes): The alternative name.
+)");
+PyDoc_STRVAR(aliases__doc__, R"(aliases()
+
+Return a dictionary mapping all aliases to names.
+
+This method is thread-safe.
+)");
+
+PyDoc_STRVAR(clearSearchCache__doc__, R"(clearSearchCache()
+
+Clear the negative search cache.
+
+Call this when :meth:`pvExistTest` might return a different result for
+a name than before, e.g. when new names become available.
+
+This method is thread-safe.
+)");
+PyDoc_STRVAR(postEvents__doc__, R"(postEvents(entries)
+
+Post events of many PVs at once.
+
+Works like calling :meth:`PV.postEvent` for every entry, but all entries
+are converted first and then posted with a single release of the GIL.
+If an entry can not be converted no event is posted.
+
+This method is thread-safe.
+
+Args:
+    entries (sequence): Sequence of ``(pv, event_mask, attributes)``
+        tuples with the arguments for :meth:`PV.postEvent`.
+)");
+PyDoc_STRVAR(publishFrame__doc__, R"(publishFrame(pvs)
+
+Publish the PVs which were marked dirty during the last frame.
+
+This method is called from the thread calling :func:`process` once per
+frame, see :meth:`setPublishRate`. The default implementation does nothing.
+
+Args:
+    pvs (list): The objects passed to :meth:`markDirty` in the order
+        they were first marked, every object only once.
+)");
+PyDoc_STRVAR(setPublishRate__doc__, R"(setPublishRate(rate)
+
+Set the number of frames per second.
+
+While frames are enabled :meth:`markDirty` collects dirty objects and
+a timer calls :meth:`publishFrame` at most ``rate`` times per second.
+``0`` disables frames, objects which are still dirty are passed to
+:meth:`publishFrame` immediately.
+
+This method is thread-safe.
+
+Args:
+    rate (float): Frames per second.
+)");
+PyDoc_STRVAR(publishRate__doc__, R"(publishRate()
+
+Return the number of frames per second, ``0`` if frames are disabled.
+
+This method is thread-safe.
+)");
+PyDoc_STRVAR(markDirty__doc__, R"(markDirty(pv)
+
+Mark ``pv`` dirty so it is passed to the next :meth:`publishFrame` call.
+
+The server holds a reference until the frame is published.
+
+This method is thread-safe.
+
+Args:
+    pv: The object to publish, usually a PV.
+
+Returns:
+    bool: ``False`` if frames are disabled and nothing was marked.
+)");
+PyDoc_STRVAR(frameCount__doc__, R"(frameCount()
+
+Return the number of frames published so far.
+
+This method is thread-safe.
+)");
+PyDoc_STRVAR(searchCacheStatistics__doc__, R"(searchCacheStatistics()
+
+Return statistics of the negative search cache.
+
+This method is thread-safe.
+
+Returns:
+    dict: A dictionary with the keys ``hits`` (searches answered by the
+    cache), ``misses`` (searches passed on to :meth:`pvExistTest`) and
+    ``size`` (number of names currently in the cache).
+)");
+
+PyDoc_STRVAR(addRoute__doc__, R"(addRoute(pattern, factory)
+
+Create PVs matching ``pattern`` on demand.
+
+``pattern`` is a glob pattern where ``*`` matches any sequence of
+characters and ``?`` matches a single character. Searches for matching
+names are answered positively. When a client attaches to a matching name
+which is neither registered nor cached ``factory(name)`` is called.
+It must return a :class:`PV` instance or ``None`` if the PV does
+not exist.
+
+Created PVs are kept in a LRU cache. When it holds more than ``route_cache``
+PVs the least recently used ones without open channels are released.
+
+Routes are checked in the order they are added after registered names
+and before :meth:`pvExistTest` and :meth:`pvAttach`. Adding a route with
+an existing pattern replaces the factory.
+
+Args:
+    pattern (bytes): The name pattern.
+    factory (callable): The factory called with the name as bytes.
+)");
+PyDoc_STRVAR(removeRoute__doc__, R"(removeRoute(pattern)
+
+Remove the route for ``pattern``.
+
+Already created PVs stay in the cache until they are evicted.
+
+Args:
+    pattern (bytes): The name pattern.
+
+Returns:
+    bool: ``False`` if no route existed for ``pattern``.
+)");
+PyDoc_STRVAR(routeCacheSize__doc__, R"(routeCacheSize()
+
+Return the number of PVs created by routes which are currently cached.
+
+This method is thread-safe.
+)");
+
+PyDoc_STRVAR(addShard__doc__, R"(addShard(address, weight=1)
+
+Add a backend server to the shard map.
+
+Searches for names which are neither registered nor match a route and
+for which :meth:`pvExistTest` returns :class:`ExistsResponse.NOT_EXISTS_HERE`
+are answered by redirecting the client to a backend server. The names are
+distributed over the backend servers with consistent hashing, so adding
+or removing a server only moves the names of that server.
+
+This method is thread-safe.
+
+Args:
+    address (tuple): A tuple ``(ip, port)`` of the backend server.
+        The IP address is encoded as a 32bit integer.
+    weight (int): Relative share of names handled by this server.
+)");
+PyDoc_STRVAR(removeShard__doc__, R"(removeShard(address)
+
+Remove a backend server from the shard map.
+
+This method is thread-safe.
+
+Args:
+    address (tuple): A tuple ``(ip, port)`` of the backend server.
+
+Returns:
+    bool: ``False`` if the server was not in the shard map.
+)");
+PyDoc_STRVAR(addShardPrefix__doc__, R"(addShardPrefix(prefix, address)
+
+Redirect all names starting with ``prefix`` to a backend server.
+
+Prefix rules take precedence over the consistent hashing of
+:meth:`addShard`. The longest matching prefix wins.
+
+This method is thread-safe.
+
+Args:
+    prefix (bytes): The name prefix.
+    address (tuple): A tuple ``(ip, port)`` of the backend server.
+)");
+PyDoc_STRVAR(removeShardPrefix__doc__, R"(removeShardPrefix(prefix)
+
+Remove a prefix rule.
+
+This method is thread-safe.
+
+Args:
+    prefix (bytes): The name prefix.
+
+Returns:
+    bool: ``False`` if no rule existed for ``prefix``.
+)");
+PyDoc_STRVAR(shardFor__doc__, R"(shardFor(name)
+
+Return the backend server for ``name``.
+
+This method is thread-safe.
+
+Args:
+    name (bytes): A PV name.
+
+Returns:
+    tuple: A tuple ``(ip, port)`` or ``None`` if the shard map is empty.
 )");
 
 PyMethodDef server_methods[] = {
     {"pvExistTest", static_cast<PyCFunction>(ServerProxy::pvExistTest), METH_VARARGS, pvExistTest__doc__},
     {"pvAttach",    static_cast<PyCFunction>(ServerProxy::pvAttach),    METH_VARARGS, pvAttach__doc__},
+    {"registerPV",  static_cast<PyCFunction>(ServerProxy::registerPV),  METH_VARARGS, registerPV__doc__},
+    {"addAlias",     static_cast<PyCFunction>(ServerProxy::addAlias),     METH_VARARGS, addAlias__doc__},
+    {"addAliases",   static_cast<PyCFunction>(ServerProxy::addAliases),   METH_VARARGS, addAliases__doc__},
+    {"loadAliases",  static_cast<PyCFunction>(ServerProxy::loadAliases),  METH_VARARGS, loadAliases__doc__},
+    {"removeAlias",  static_cast<PyCFunction>(ServerProxy::removeAlias),  METH_VARARGS, removeAlias__doc__},
+    {"resolveAlias", static_cast<PyCFunction>(ServerProxy::resolveAlias), METH_VARARGS, resolveAlias__doc__},
+    {"aliases",      static_cast<PyCFunction>(ServerProxy::aliases),      METH_NOARGS,  aliases__doc__},
+    {"clearSearchCache",      static_cast<PyCFunction>(ServerProxy::clearSearchCache),      METH_NOARGS, clearSearchCache__doc__},
+    {"postEvents",            static_cast<PyCFunction>(ServerProxy::postEvents),            METH_O,      postEvents__doc__},
+    {"publishFrame",          static_cast<PyCFunction>(ServerProxy::publishFrame),          METH_O,      publishFrame__doc__},
+    {"setPublishRate",        static_cast<PyCFunction>(ServerProxy::setPublishRate),        METH_O,      setPublishRate__doc__},
+    {"publishRate",           static_cast<PyCFunction>(ServerProxy::publishRate),           METH_NOARGS, publishRate__doc__},
+    {"markDirty",             static_cast<PyCFunction>(ServerProxy::markDirty),             METH_O,      markDirty__doc__},
+    {"frameCount",            static_cast<PyCFunction>(ServerProxy::frameCount),            METH_NOARGS, frameCount__doc__},
+    {"searchCacheStatistics", static_cast<PyCFunction>(ServerProxy::searchCacheStatistics), METH_NOARGS, searchCacheStatistics__doc__},
+    {"addRoute",       static_cast<PyCFunction>(ServerProxy::addRoute),       METH_VARARGS, addRoute__doc__},
+    {"removeRoute",    static_cast<PyCFunction>(ServerProxy::removeRoute),    METH_VARARGS, removeRoute__doc__},
+    {"routeCacheSize", static_cast<PyCFunction>(ServerProxy::routeCacheSize), METH_NOARGS,  routeCacheSize__doc__},
+    {"addShard",          reinterpret_cast<PyCFunction>(ServerProxy::addShard),          METH_VARARGS | METH_KEYWORDS, addShard__doc__},
+    {"removeShard",       static_cast<PyCFunction>(ServerProxy::removeShard),       METH_VARARGS, removeShard__doc__},
+    {"addShardPrefix",    static_cast<PyCFunction>(ServerProxy::addShardPrefix),    METH_VARARGS, addShardPrefix__doc__},
+    {"removeShardPrefix", static_cast<PyCFunction>(ServerProxy::removeShardPrefix), METH_VARARGS, removeShardPrefix__doc__},
+    {"shardFor",          static_cast<PyCFunction>(ServerProxy::shardFor),          METH_VARARGS, shardFor__doc__},
     {nullptr}
 };
 
@@ -194,7 +1147,7 @@ PyMemberDef server_members[] = {
     {nullptr}
 };
 
-PyDoc_STRVAR(server__doc__, R"(
+PyDoc_STRVAR(server__doc__, R"(Server(search_cache=0, search_cache_age=60.0, route_cache=1000)
 Server class.
 
 This class handles requests for PV connections.
@@ -202,6 +1155,27 @@ This class handles requests for PV connections.
 When creating a channel access server a user defined class should derive
 from this class and implement the methods :meth:`pvExistTest` and
 :meth:`pvAttach`. The default implementations reject all requests.
+These methods are only called for names which are not registered
+with :meth:`registerPV` or :meth:`addAlias`, do not match a route added with :meth:`addRoute`
+and are not in the negative search cache. Names for which :meth:`pvExistTest`
+returns :class:`ExistsResponse.NOT_EXISTS_HERE` are redirected by the
+shard map (see :meth:`addShard`).
+
+Names for which :meth:`pvExistTest` returned
+:class:`ExistsResponse.NOT_EXISTS_HERE` can be remembered in a negative
+search cache so that repeated searches for names hosted elsewhere do
+not call into Python. The cache is probabilistic, it can rarely
+hide a name until it is cleared. It is cleared automatically after
+``search_cache_age`` seconds and can be cleared with
+:meth:`clearSearchCache`.
+
+Args:
+    search_cache (int): Number of names kept in the negative search cache.
+        ``0`` disables the cache.
+    search_cache_age (float): Maximum age of the negative search cache
+        in seconds.
+    route_cache (int): Number of PVs created by :meth:`addRoute` factories
+        which are kept in the cache.
 
 It is unspecified if the server uses multiple threads internally. Care
 must be taken when implementing the above methods.
@@ -226,10 +1200,10 @@ PyTypeObject server_type = {
     nullptr,                                   /* tp_getattro */
     nullptr,                                   /* tp_setattro */
     nullptr,                                   /* tp_as_buffer */
-    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,  /* tp_flags */
+    Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE | Py_TPFLAGS_HAVE_GC, /* tp_flags */
     server__doc__,                             /* tp_doc */
-    nullptr,                                   /* tp_traverse */
-    nullptr,                                   /* tp_clear */
+    server_traverse,                           /* tp_traverse */
+    server_clear,                              /* tp_clear */
     nullptr,                                   /* tp_richcompare */
     0,                                         /* tp_weaklistoffset */
     nullptr,                                   /* tp_iter */
@@ -262,4 +1236,9 @@ void destroy_server_type()
     Py_DECREF(&server_type);
 }
 
+casEventMask event_mask(caServer const& server, unsigned events)
+{
+    return static_cast<ServerProxy const&>(server).eventMask(events);
+}
+
 }
@@ -3,6 +3,9 @@
 
 #include <Python.h>
 
+class caServer;
+class casEventMask;
+
 namespace cas {
 
 /** Create the server type.
@@ -14,6 +17,12 @@ PyObject* create_server_type();
  */
 void destroy_server_type();
 
+/** Return the event mask of ``server`` for the ``DBE_*`` bits in ``events``.
+ *
+ * ``server`` must be created by this module. Does not need the GIL.
+ */
+casEventMask event_mask(caServer const& server, unsigned events);
+
 }
 
 #endif
@@ -0,0 +1,174 @@
+#include "server_thread.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+#include <Python.h>
+#include <fdManager.h>
+
+#include "convert.hpp"
+#include "event_queue.hpp"
+
+namespace cas {
+namespace {
+
+// Upper bound for a sleep of the loop, everything else wakes it earlier
+constexpr double maximum_wait = 10.0;
+
+// Descriptors of the wakeup, created once and never closed so that
+// producers can wake the thread without synchronizing with stop.
+// With eventfd both are the same descriptor, otherwise a pipe is used.
+int wakeup_read = -1;
+int wakeup_write = -1;
+std::once_flag wakeup_created;
+
+std::atomic<bool> wakeup_pending{false};
+std::atomic<bool> stopping{false};
+std::atomic<bool> running{false};
+
+// Protects the thread object and the number of users
+std::mutex thread_mutex;
+std::thread thread;
+unsigned users = 0;
+
+void create_wakeup()
+{
+#if defined(__linux__)
+    int fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd >= 0) {
+        wakeup_read = fd;
+        wakeup_write = fd;
+    }
+#else
+    int fds[2];
+    if (pipe(fds) == 0) {
+        for (int fd : fds) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+        wakeup_read = fds[0];
+        wakeup_write = fds[1];
+    }
+#endif
+}
+
+void consume_wakeup()
+{
+    // Non-blocking, read until the counter or the pipe is empty
+    std::uint64_t buffer[8];
+    while (read(wakeup_read, buffer, sizeof(buffer)) > 0) {}
+}
+
+// Makes the wakeup descriptor readable for the fdManager loop
+class WakeupRegistration : public fdReg {
+public:
+    WakeupRegistration()
+        : fdReg(wakeup_read, fdrRead)
+    {}
+
+private:
+    virtual void callBack() override
+    {
+        consume_wakeup();
+    }
+};
+
+void run()
+{
+    // fdManager is not thread-safe, register from the loop thread
+    WakeupRegistration registration;
+    // Events posted from here bypass the queue
+    ProcessScope scope;
+
+    while (not stopping.load()) {
+        // Reset before draining, a later enqueue wakes the loop again
+        wakeup_pending.store(false);
+        drain_event_queue();
+
+        fileDescriptorManager.process(maximum_wait);
+
+        // Arrays released by the server while processing
+        if (has_deferred_decrefs()) {
+            PyGILState_STATE gstate = PyGILState_Ensure();
+                release_deferred_references();
+            PyGILState_Release(gstate);
+        }
+    }
+    drain_event_queue();
+    running.store(false);
+}
+
+}
+
+bool start_process_thread()
+{
+    std::call_once(wakeup_created, create_wakeup);
+    if (wakeup_read < 0) return false;
+
+    std::lock_guard<std::mutex> lock(thread_mutex);
+    if (users++ > 0) return true;
+
+    // A thread which stopped itself from a callback is detached,
+    // wait until its loop has ended
+    while (running.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    stopping.store(false);
+    running.store(true);
+    try {
+        thread = std::thread(run);
+    } catch (...) {
+        running.store(false);
+        --users;
+        return false;
+    }
+    return true;
+}
+
+void stop_process_thread(bool force)
+{
+    std::thread stopped;
+    {
+        std::lock_guard<std::mutex> lock(thread_mutex);
+        if (users == 0) return;
+        users = force ? 0 : users - 1;
+        if (users > 0) return;
+
+        stopping.store(true);
+        wake_process_thread();
+        if (thread.get_id() == std::this_thread::get_id()) {
+            // Called from a callback, the loop ends when it returns
+            thread.detach();
+            return;
+        }
+        std::swap(stopped, thread);
+    }
+    if (stopped.joinable()) stopped.join();
+}
+
+void wake_process_thread()
+{
+    if (wakeup_write < 0 or wakeup_pending.load() or wakeup_pending.exchange(true)) return;
+
+    std::uint64_t const one = 1;
+    ssize_t result;
+    do {
+        result = write(wakeup_write, &one, sizeof(one));
+    } while (result < 0 and errno == EINTR);
+}
+
+bool process_thread_running()
+{
+    return running.load();
+}
+
+}
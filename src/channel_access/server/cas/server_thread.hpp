@@ -0,0 +1,38 @@
+#ifndef INCLUDE_GUARD_7F1C8D52_3A96_4E0B_B5D4_92E07A6C1F38
+#define INCLUDE_GUARD_7F1C8D52_3A96_4E0B_B5D4_92E07A6C1F38
+
+namespace cas {
+
+/** Start the native thread running the fdManager loop.
+ *
+ * The thread is shared by all servers, every call must be paired with
+ * ``stop_process_thread()``. Only the first call starts it. The thread
+ * only takes the GIL inside callbacks and to release references dropped
+ * without it. Does not need the GIL.
+ *
+ * Returns ``false`` if the thread or its wakeup descriptor can not be
+ * created.
+ */
+bool start_process_thread();
+
+/** Stop the native thread after the last user stopped it.
+ *
+ * Waits until the thread has finished unless it is called from the
+ * thread itself. ``force`` stops the thread regardless of the number
+ * of users. Must be called without the GIL.
+ */
+void stop_process_thread(bool force = false);
+
+/** Wake the native thread so that it drains the event queue and
+ * recalculates its timers. Cheap if a wakeup is already pending.
+ * Does not need the GIL.
+ */
+void wake_process_thread();
+
+/** Return ``true`` if the native thread is running.
+ */
+bool process_thread_running();
+
+}
+
+#endif
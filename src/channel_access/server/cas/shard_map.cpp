@@ -0,0 +1,142 @@
+#include "shard_map.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "registry.hpp"
+
+namespace cas {
+namespace {
+
+// FNV-1a spreads similar names badly over the ring, mix the bits (splitmix64 finalizer)
+std::uint64_t mix(std::uint64_t hash)
+{
+    hash ^= hash >> 30;
+    hash *= 0xbf58476d1ce4e5b9ull;
+    hash ^= hash >> 27;
+    hash *= 0x94d049bb133111ebull;
+    hash ^= hash >> 31;
+    return hash;
+}
+
+std::uint64_t ring_hash(char const* name, std::size_t length)
+{
+    return mix(hash_name(name, length));
+}
+
+}
+
+constexpr unsigned ShardMap::virtual_nodes;
+
+ShardMap::ShardMap()
+    : empty{true}
+{
+}
+
+void ShardMap::addPrefix(std::string const& prefix, Endpoint endpoint)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = std::find_if(prefixes.begin(), prefixes.end(),
+        [&prefix](std::pair<std::string, Endpoint> const& rule) { return rule.first == prefix; });
+    if (it != prefixes.end()) {
+        it->second = endpoint;
+    } else {
+        // Keep longer prefixes first so the first match is the longest one
+        auto position = std::find_if(prefixes.begin(), prefixes.end(),
+            [&prefix](std::pair<std::string, Endpoint> const& rule) { return rule.first.size() < prefix.size(); });
+        prefixes.emplace(position, prefix, endpoint);
+    }
+    empty = false;
+}
+
+bool ShardMap::removePrefix(std::string const& prefix)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = std::find_if(prefixes.begin(), prefixes.end(),
+        [&prefix](std::pair<std::string, Endpoint> const& rule) { return rule.first == prefix; });
+    if (it == prefixes.end()) return false;
+
+    prefixes.erase(it);
+    empty = prefixes.empty() and shards.empty();
+    return true;
+}
+
+void ShardMap::addShard(Endpoint endpoint, unsigned weight)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = std::find_if(shards.begin(), shards.end(),
+        [&endpoint](std::pair<Endpoint, unsigned> const& shard) { return shard.first == endpoint; });
+    if (it != shards.end()) {
+        it->second = weight;
+    } else {
+        shards.emplace_back(endpoint, weight);
+    }
+    rebuildRing();
+    empty = false;
+}
+
+bool ShardMap::removeShard(Endpoint endpoint)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = std::find_if(shards.begin(), shards.end(),
+        [&endpoint](std::pair<Endpoint, unsigned> const& shard) { return shard.first == endpoint; });
+    if (it == shards.end()) return false;
+
+    shards.erase(it);
+    rebuildRing();
+    empty = prefixes.empty() and shards.empty();
+    return true;
+}
+
+void ShardMap::rebuildRing()
+{
+    ring.clear();
+    for (auto const& shard : shards) {
+        Endpoint const& endpoint = shard.first;
+        for (unsigned i = 0; i < shard.second * virtual_nodes; ++i) {
+            // The points only depend on the endpoint, not on the other shards
+            std::uint32_t const key[] = { endpoint.host, endpoint.port, i };
+            ring.emplace_back(ring_hash(reinterpret_cast<char const*>(key), sizeof(key)), endpoint);
+        }
+    }
+    std::sort(ring.begin(), ring.end(),
+        [](std::pair<std::uint64_t, Endpoint> const& a, std::pair<std::uint64_t, Endpoint> const& b) {
+            return a.first < b.first;
+        });
+}
+
+bool ShardMap::lookup(char const* name, Endpoint& endpoint) const
+{
+    if (empty) return false;
+
+    std::size_t const length = std::strlen(name);
+    std::uint64_t const hash = ring_hash(name, length);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto const& rule : prefixes) {
+        if (rule.first.size() <= length and std::memcmp(rule.first.data(), name, rule.first.size()) == 0) {
+            endpoint = rule.second;
+            return true;
+        }
+    }
+
+    if (ring.empty()) return false;
+
+    // The first point after the hash owns the name, wrap around at the end
+    auto it = std::upper_bound(ring.begin(), ring.end(), hash,
+        [](std::uint64_t value, std::pair<std::uint64_t, Endpoint> const& point) { return value < point.first; });
+    if (it == ring.end()) it = ring.begin();
+    endpoint = it->second;
+    return true;
+}
+
+void ShardMap::clear()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    prefixes.clear();
+    shards.clear();
+    ring.clear();
+    empty = true;
+}
+
+}
@@ -0,0 +1,89 @@
+#ifndef INCLUDE_GUARD_28E1E338_A702_4AAB_B5DD_860E18641F81
+#define INCLUDE_GUARD_28E1E338_A702_4AAB_B5DD_860E18641F81
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace cas {
+
+/** Address of a channel access server, in host byte order.
+ */
+struct Endpoint {
+    std::uint32_t host;
+    std::uint16_t port;
+
+    bool operator==(Endpoint const& other) const
+    {
+        return host == other.host and port == other.port;
+    }
+};
+
+/** Search redirection table.
+ *
+ * Maps PV names to the server which hosts them. Explicit prefix rules are
+ * checked first, the longest matching prefix wins. All other names are
+ * distributed over the shards with consistent hashing, so adding or
+ * removing a shard only moves the names of that shard.
+ *
+ * All methods are thread-safe and do not need the GIL.
+ */
+class ShardMap {
+public:
+    ShardMap();
+
+    ShardMap(ShardMap const&) = delete;
+    ShardMap& operator=(ShardMap const&) = delete;
+
+    /** Redirect all names starting with ``prefix`` to ``endpoint``.
+     * Replaces an existing rule for the same prefix.
+     */
+    void addPrefix(std::string const& prefix, Endpoint endpoint);
+
+    /** Remove a prefix rule. Return ``false`` if there is no such rule.
+     */
+    bool removePrefix(std::string const& prefix);
+
+    /** Add a shard to the hash ring. ``weight`` scales the share of names
+     * the shard receives. Adding an existing shard changes its weight.
+     */
+    void addShard(Endpoint endpoint, unsigned weight);
+
+    /** Remove a shard from the hash ring. Return ``false`` if there is
+     * no such shard.
+     */
+    bool removeShard(Endpoint endpoint);
+
+    /** Find the server for ``name``.
+     * Return ``false`` if neither a prefix rule nor a shard exists.
+     */
+    bool lookup(char const* name, Endpoint& endpoint) const;
+
+    /** Remove all rules and shards.
+     */
+    void clear();
+
+private:
+    // only call with mutex held
+    void rebuildRing();
+
+    // Points on the hash ring per unit of weight
+    static constexpr unsigned virtual_nodes = 64;
+
+    mutable std::mutex mutex;
+    // Sorted by descending length
+    std::vector<std::pair<std::string, Endpoint>> prefixes;
+    std::vector<std::pair<Endpoint, unsigned>> shards;
+    // Sorted by hash
+    std::vector<std::pair<std::uint64_t, Endpoint>> ring;
+    // Allows skipping the lock when the map is not used
+    std::atomic<bool> empty;
+};
+
+}
+
+#endif
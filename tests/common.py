@@ -29,8 +29,8 @@ class CagetError(RuntimeError):
 class CaputError(RuntimeError):
     pass
 
-def cacmd(args):
-    environment = {
+def caenv():
+    return {
         'PATH': os.environ.get('PATH'),
         'EPICS_BASE': os.environ.get('EPICS_BASE'),
         'EPICS_HOST_ARCH': os.environ.get('EPICS_HOST_ARCH'),
@@ -39,11 +39,13 @@ def cacmd(args):
         'EPICS_CA_SERVER_PORT': EPICS_CA_SERVER_PORT,
         'EPICS_CA_REPEATER_PORT': EPICS_CA_REPEATER_PORT
     }
+
+def cacmd(args):
     with subprocess.Popen(args,
             stdin=subprocess.DEVNULL,
             stdout=subprocess.PIPE,
             stderr=subprocess.PIPE,
-            env=environment,
+            env=caenv(),
             universal_newlines=True) as process:
         try:
             stdout, stderr = process.communicate()
@@ -56,6 +58,10 @@ def cacmd(args):
                     output=stdout, stderr=stderr)
     return subprocess.CompletedProcess(process.args, retcode, stdout, stderr)
 
+def store_attributes(pv):
+    """ Store the attributes natively so that reads return posted values. """
+    pv._pv.storeAttributes(pv._pv._encode(pv.attributes))
+
 def caget(pv, as_string=False, array=False, timeout=None):
     if timeout is None:
         timeout = 0.1
@@ -97,3 +103,26 @@ def caput(pv, value, timeout=None):
     if 'CA.Client.Exception' in result.stderr:
         raise CaputError
     return result.stdout.strip()
+
+
+class Camonitor:
+    """ Run camonitor in the background and collect the monitored values. """
+    def __init__(self, pv, timeout=None):
+        if timeout is None:
+            timeout = 1.0
+
+        self.process = subprocess.Popen(['camonitor', '-t', 'n', '-n', '-w', str(timeout), pv],
+            stdin=subprocess.DEVNULL,
+            stdout=subprocess.PIPE,
+            stderr=subprocess.DEVNULL,
+            env=caenv(),
+            universal_newlines=True)
+        # The initial value is received once the subscription exists
+        self.lines = [ self.process.stdout.readline() ]
+
+    def stop(self):
+        """ Stop camonitor and return the values as strings. """
+        self.process.terminate()
+        stdout, _ = self.process.communicate()
+        self.lines.extend(stdout.splitlines())
+        return [ line.split()[-1] for line in self.lines if line.strip() ]
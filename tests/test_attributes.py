@@ -79,3 +79,11 @@ def test_attribute_value_timestamp(server):
         'value': 42
     })
     assert(pv.value_timestamp == (42, dt))
+
+def test_attribute_dict_get(server):
+    pv = server.createPV('CAS:Test', ca.Type.CHAR, attributes={
+        'value': 1
+    })
+    assert(int(common.caget('CAS:Test')) == 1)
+    pv.attributes = { 'value': 42 }
+    assert(int(common.caget('CAS:Test')) == 42)
@@ -1,5 +1,7 @@
 import pytest
 
+import asyncio
+import functools
 import threading
 import channel_access.common as ca
 import channel_access.server as cas
@@ -196,3 +198,123 @@ def test_failing_async_read_handler(server):
         common.caget('CAS:Test', timeout=2)
     assert(executed)
     timer.join()
+
+def test_attach_handler(server):
+    def exist_handler(server, name, context):
+        return name == 'CAS:Dynamic'
+
+    def attach_handler(server, name, context):
+        async_attach = cas.AsyncPVAttach(server, context)
+        def complete():
+            pv = server.createPV(name, ca.Type.LONG)
+            pv.value = 5
+            async_attach.complete(pv)
+        threading.Timer(0.01, complete).start()
+        return async_attach
+
+    server.exist_handler = exist_handler
+    server.attach_handler = attach_handler
+    assert(int(common.caget('CAS:Dynamic', timeout=1)) == 5)
+
+def test_legacy_server_signature(server):
+    pv = cas.PV('CAS:Legacy', ca.Type.LONG, attributes={ 'value': 7 })
+    # Low-level overrides without the context parameter
+    server._server.pvExistTest = lambda client, name: name == b'CAS:Legacy'
+    server._server.pvAttach = lambda name: pv._pv
+    assert(int(common.caget('CAS:Legacy', timeout=1)) == 7)
+
+def test_legacy_server_signature_callables(server):
+    pv = cas.PV('CAS:Legacy', ca.Type.LONG, attributes={ 'value': 7 })
+
+    def exist_test(pv_name, client, name):
+        return name == pv_name
+
+    class Attach:
+        def __call__(self, name):
+            return pv._pv
+
+    # Partial objects and callable objects without the context parameter
+    server._server.pvExistTest = functools.partial(exist_test, b'CAS:Legacy')
+    server._server.pvAttach = Attach()
+    assert(int(common.caget('CAS:Legacy', timeout=1)) == 7)
+
+def test_exist_handler_return_value():
+    assert(cas._to_exists_response(True) == cas.ExistsResponse.EXISTS_HERE)
+    assert(cas._to_exists_response(False) == cas.ExistsResponse.NOT_EXISTS_HERE)
+    assert(cas._to_exists_response(('127.0.0.1', 5064)) == (0x7f000001, 5064))
+    with pytest.raises(TypeError):
+        cas._to_exists_response('CAS:Test')
+    with pytest.raises(TypeError):
+        cas._to_exists_response(None)
+
+def test_coroutine_handlers(server):
+    loop = asyncio.new_event_loop()
+    thread = threading.Thread(target=loop.run_forever)
+    thread.start()
+
+    async def read_handler(pv, context):
+        await asyncio.sleep(0.1)
+        return { 'value': 3 }
+
+    async def write_handler(pv, value, timestamp, context):
+        await asyncio.sleep(0.1)
+        return (value + 1, timestamp)
+
+    try:
+        pv = server.createPV('CAS:Test', ca.Type.LONG, loop=loop,
+            read_handler=read_handler, write_handler=write_handler)
+        assert(int(common.caget('CAS:Test', timeout=2)) == 3)
+        common.caput('CAS:Test', 5, timeout=2)
+        assert(pv.value == 6)
+    finally:
+        loop.call_soon_threadsafe(loop.stop)
+        thread.join()
+        loop.close()
+
+def test_coroutine_returns_async(server):
+    loop = asyncio.new_event_loop()
+    thread = threading.Thread(target=loop.run_forever)
+    thread.start()
+
+    async def complete(completion):
+        return completion
+
+    def read_handler(pv, context):
+        return complete(cas.AsyncRead(pv, context))
+
+    try:
+        pv = server.createPV('CAS:Test', ca.Type.LONG, loop=loop,
+            read_handler=read_handler)
+        # The read fails instead of waiting for the completion
+        with pytest.raises(common.CagetError):
+            common.caget('CAS:Test', timeout=2)
+    finally:
+        loop.call_soon_threadsafe(loop.stop)
+        thread.join()
+        loop.close()
+
+def test_await_completion(server):
+    loop = asyncio.new_event_loop()
+    completion = None
+    ready = threading.Event()
+
+    def handler(pv, context):
+        nonlocal completion
+        completion = cas.AsyncRead(pv, context)
+        ready.set()
+        return completion
+
+    async def complete():
+        await loop.run_in_executor(None, ready.wait)
+        completion.complete({ 'value': 1 })
+        return await completion
+
+    pv = server.createPV('CAS:Test', ca.Type.CHAR, read_handler=handler)
+    thread = threading.Thread(target=common.caget, args=('CAS:Test',), kwargs={ 'timeout': 2 })
+    thread.start()
+    try:
+        assert(loop.run_until_complete(complete()))
+    finally:
+        thread.join()
+        loop.close()
+    assert(pv.value == 1)
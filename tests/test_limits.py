@@ -57,6 +57,24 @@ def test_control_limits_array_numpy(server, type_):
     assert(numpy.all(numpy.equal(pv.value, test_values)))
 
 
+@pytest.mark.skipif(not cas.numpy, reason="No numpy support")
+@pytest.mark.parametrize("dtype", [ 'int16', 'int32', 'int64', 'float32', 'float64' ])
+def test_control_limits_numpy_dtype(server, dtype):
+    import numpy
+
+    pv = server.createPV('CAS:Test', ca.Type.DOUBLE, attributes = {
+        'control_limits': (-5.5, 10.5)
+    }, use_numpy=True)
+    test_values = numpy.array([ -10, 2, 20 ] * 11, dtype=dtype)
+    pv.value = test_values
+    assert(pv.value.dtype == numpy.dtype(dtype))
+    if numpy.dtype(dtype).kind == 'f':
+        assert(numpy.all(numpy.equal(pv.value, [ -5.5, 2, 10.5 ] * 11)))
+    else:
+        assert(numpy.all(numpy.equal(pv.value, [ -5, 2, 10 ] * 11)))
+    # The argument is not changed
+    assert(numpy.all(numpy.equal(test_values, [ -10, 2, 20 ] * 11)))
+
 
 @pytest.mark.parametrize("type_", common.INT_TYPES + common.FLOAT_TYPES)
 def test_alarm_limits(server, type_):
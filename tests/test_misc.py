@@ -1,4 +1,6 @@
 import pytest
+import time
+from datetime import datetime, timezone
 
 import channel_access.common as ca
 import channel_access.server as cas
@@ -16,6 +18,12 @@ def test_alias(server):
     with pytest.raises(common.CagetError):
         common.caget('CAS:Alias')
 
+def test_alias_encoding(server):
+    pv = server.createPV('CAS:T\xfcst', ca.Type.CHAR, encoding='latin-1')
+    server.addAlias('CAS:\xc4lias', 'CAS:T\xfcst', encoding='latin-1')
+    # Decoded like the name of the PV
+    assert(server.aliases == { 'CAS:\xc4lias': 'CAS:T\xfcst' })
+
 def test_dynamic_size(server):
     pv = server.createPV('CAS:Test', ca.Type.CHAR, attributes = {
         'value': 42
@@ -102,3 +110,373 @@ def test_different_length_array_numpy(server, type_):
     other_values = numpy.arange(5)
     pv.value = other_values
     assert(pv.count == 5)
+
+def test_changed_length_read(server):
+    pv = server.createPV('CAS:Test', ca.Type.LONG, count=10, use_numpy=False)
+    assert(len(common.caget('CAS:Test', array=True)) == 10)
+    pv.value = tuple(range(5))
+    assert(len(common.caget('CAS:Test', array=True)) == 5)
+
+def test_replaced_pv(server):
+    old_pv = server.createPV('CAS:Test', ca.Type.CHAR, attributes = {
+        'value': 1
+    })
+    pv = server.createPV('CAS:Test', ca.Type.CHAR, attributes = {
+        'value': 2
+    })
+    value = int(common.caget('CAS:Test'))
+    assert(value == 2)
+
+def test_bulk_aliases(server, tmpdir):
+    pv = server.createPV('CAS:Test', ca.Type.CHAR, attributes = {
+        'value': 42
+    })
+    server.addAliases({ 'CAS:Alias{}'.format(i): 'CAS:Test' for i in range(1000) })
+    alias_file = tmpdir.join('aliases.txt')
+    alias_file.write('# alias name\n\nCAS:FileAlias CAS:Test\n')
+    assert(server.loadAliases(str(alias_file)) == 1)
+
+    assert(int(common.caget('CAS:Alias999')) == 42)
+    assert(int(common.caget('CAS:FileAlias')) == 42)
+    assert(server.retreivePV('CAS:FileAlias') is pv)
+    assert(len(server.aliases) == 1001)
+
+def test_search_cache(server):
+    with pytest.raises(common.CagetError):
+        common.caget('CAS:Unknown')
+    with pytest.raises(common.CagetError):
+        common.caget('CAS:Unknown')
+    statistics = server.search_cache_statistics
+    assert(statistics['misses'] >= 1)
+    assert(statistics['hits'] >= 1)
+
+def test_alias_after_failed_search(server):
+    pv = server.createPV('CAS:Test', ca.Type.CHAR, attributes = {
+        'value': 42
+    })
+    with pytest.raises(common.CagetError):
+        common.caget('CAS:Alias')
+    server.addAlias('CAS:Alias', 'CAS:Test')
+    value = int(common.caget('CAS:Alias'))
+    assert(value == 42)
+
+def test_route(server):
+    created = []
+    def factory(server, name):
+        created.append(name)
+        pv = server.createPV(name, ca.Type.LONG)
+        pv.value = int(name.split(':')[1])
+        return pv
+
+    server.addRoute('CAS:*:VAL', factory)
+    assert(int(common.caget('CAS:1:VAL')) == 1)
+    assert(int(common.caget('CAS:2:VAL')) == 2)
+    assert(int(common.caget('CAS:1:VAL')) == 1)
+    # Created PVs are cached
+    assert(created == [ 'CAS:1:VAL', 'CAS:2:VAL' ])
+    assert(server.route_cache_size == 2)
+    with pytest.raises(common.CagetError):
+        common.caget('CAS:1:OTHER')
+
+def test_native_attributes(server):
+    timestamp = datetime(2020, 1, 1, 12, 30, 15, 500, tzinfo=timezone.utc)
+    attributes = cas.cas.Attributes(value=3, status=ca.Status.LOW, severity=ca.Severity.MINOR,
+        timestamp=timestamp, unit=b'mm', display_limits=(0, 10))
+    assert(attributes.value == 3)
+    assert(attributes.status == ca.Status.LOW.value)
+    assert(attributes.severity == ca.Severity.MINOR.value)
+    assert(attributes.timestamp == ca.datetime_to_epics(timestamp))
+    assert(attributes.unit == b'mm')
+    assert(attributes.display_limits == (0, 10))
+    assert(attributes.alarm_limits is None)
+
+    pv = server.createPV('CAS:Test', ca.Type.LONG, attributes = {
+        'value': 42,
+        'timestamp': timestamp
+    })
+    assert(int(common.caget('CAS:Test')) == 42)
+
+def test_post_value(server):
+    pv = server.createPV('CAS:Test', ca.Type.LONG, attributes = {
+        'value': 42
+    })
+    # Low-level fast path, updates the stored value
+    common.store_attributes(pv)
+    pv._pv.postValue(ca.Events.VALUE, 23, ca.Status.NO_ALARM, ca.Severity.NO_ALARM)
+    assert(int(common.caget('CAS:Test')) == 23)
+
+    # Without stored attributes only monitors are notified
+    pv._pv.clearStore()
+    pv._pv.postValue(ca.Events.VALUE, 24, ca.Status.NO_ALARM, ca.Severity.NO_ALARM)
+    assert(int(common.caget('CAS:Test')) == 42)
+
+def test_max_event_rate(server):
+    pv = server.createPV('CAS:Test', ca.Type.LONG, max_event_rate=1)
+    assert(pv.max_event_rate == 1)
+    # Attach the PV to the server
+    assert(int(common.caget('CAS:Test')) == 0)
+
+    for i in range(10):
+        pv._pv.postValue(ca.Events.VALUE, i)
+    # The first event is posted, the others wait for the timer
+    assert(pv.event_statistics == { 'conflated': 9, 'dropped': 8 })
+
+    pv.max_event_rate = 0
+    assert(pv.max_event_rate == 0)
+    pv._pv.postValue(ca.Events.VALUE, 10)
+    assert(pv.event_statistics == { 'conflated': 9, 'dropped': 8 })
+
+def test_publish_rate(server):
+    notifications = []
+    def monitor(pv, attributes):
+        notifications.append(attributes['value'])
+
+    pv = server.createPV('CAS:Test', ca.Type.LONG, monitor=monitor)
+    server.publish_rate = 1
+    assert(server.publish_rate == 1)
+
+    # The events are only published with the next frame
+    for i in range(10):
+        pv.value = i
+    assert(notifications == [])
+    assert(pv.value == 9)
+    # Reads don't wait for the frame
+    assert(int(common.caget('CAS:Test')) == 9)
+
+    # Disabling frames publishes all dirty PVs with a single event
+    server.publish_rate = 0
+    assert(notifications == [ 9 ])
+    assert(int(common.caget('CAS:Test')) == 9)
+
+    pv.value = 10
+    assert(notifications == [ 9, 10 ])
+
+def test_metadata_store(server):
+    pv = server.createPV('CAS:Test', ca.Type.DOUBLE)
+    calls = []
+    store_attributes = pv._pv.storeAttributes
+    def record(attributes, update_metadata=True):
+        calls.append(update_metadata)
+        return store_attributes(attributes, update_metadata)
+    pv._pv.storeAttributes = record
+
+    monitor = common.Camonitor('CAS:Test')
+    try:
+        # Value and timestamp updates reuse the stored meta data
+        pv.value = 1
+        pv.value = 2
+        assert(calls == [ False, False ])
+        pv.unit = 'mm'
+        assert(calls == [ False, False, True ])
+    finally:
+        monitor.stop()
+
+def test_store_read(server):
+    pv = server.createPV('CAS:Test', ca.Type.LONG)
+    reads = []
+    read = pv._pv.read
+    def record(context):
+        reads.append(context)
+        return read(context)
+    pv._pv.read = record
+
+    # Without subscribers the store is updated too
+    pv.value = 5
+    assert(int(common.caget('CAS:Test')) == 5)
+    pv.value = 6
+    assert(int(common.caget('CAS:Test')) == 6)
+    assert(reads == [])
+
+def test_event_queue(server):
+    pv = server.createPV('CAS:Test', ca.Type.LONG)
+    # Attach the PV to the server
+    assert(int(common.caget('CAS:Test')) == 0)
+
+    common.store_attributes(pv)
+    cas.cas.setEventQueue(1024)
+    try:
+        statistics = server.event_queue_statistics
+        assert(statistics['enabled'])
+        assert(statistics['capacity'] == 1024)
+
+        for i in range(10):
+            pv._pv.postValue(ca.Events.VALUE, i)
+        # The server thread posts the queued events
+        assert(int(common.caget('CAS:Test')) == 9)
+        statistics = server.event_queue_statistics
+        assert(statistics['posted'] >= 10)
+        assert(statistics['high_water'] >= 1)
+
+        with pytest.raises(ValueError):
+            cas.cas.setEventQueue(2048)
+    finally:
+        cas.cas.setEventQueue(0)
+    assert(not server.event_queue_statistics['enabled'])
+
+def test_event_queue_order(server):
+    pv = server.createPV('CAS:Test', ca.Type.LONG)
+    monitor = common.Camonitor('CAS:Test')
+
+    cas.cas.setEventQueue(1024)
+    try:
+        # Overflowing events are posted directly, the queued ones
+        # have to be posted before them
+        for i in range(1, 10001):
+            pv._pv.postValue(ca.Events.VALUE, i)
+    finally:
+        # Disabling posts the remaining queued events
+        cas.cas.setEventQueue(0)
+    time.sleep(0.5)
+    values = list(map(int, monitor.stop()))
+    assert(values == sorted(values))
+    assert(values[-1] == 10000)
+
+def test_shutdown(server):
+    server.createPV('CAS:Test', ca.Type.LONG)
+    assert(int(common.caget('CAS:Test')) == 0)
+
+    # The server thread is woken up instead of waiting for its
+    # timeout of 10 seconds
+    start = time.monotonic()
+    server.shutdown()
+    assert(time.monotonic() - start < 1.0)
+    # A second shutdown does nothing
+    server.shutdown()
+
+def test_update_pvs(server):
+    pvs = [ server.createPV('CAS:Test{}'.format(i), ca.Type.LONG) for i in range(10) ]
+    server.updatePVs((pv, { 'value': i }) for i, pv in enumerate(pvs))
+    for i in range(10):
+        assert(pvs[i].value == i)
+        assert(int(common.caget('CAS:Test{}'.format(i))) == i)
+
+@pytest.mark.skipif(not cas.numpy, reason="No numpy support")
+def test_numpy_reference(server):
+    import numpy
+
+    pv = server.createPV('CAS:Test', ca.Type.DOUBLE, use_numpy=True, attributes = {
+        'value': numpy.zeros(1000)
+    })
+    data = numpy.arange(1000, dtype=numpy.float64)
+    pv.value = data
+    # The server must not see later changes of the array
+    data[:] = 0
+    value = list(map(float, common.caget('CAS:Test', array=True)))
+    assert(value == list(range(1000)))
+    assert(pv.value.flags.writeable)
+
+@pytest.mark.skipif(not cas.numpy, reason="No numpy support")
+def test_numpy_convert(server):
+    import numpy
+
+    pv = server.createPV('CAS:Test', ca.Type.FLOAT, count=13)
+    common.store_attributes(pv)
+    pv._pv.postValue(ca.Events.VALUE, numpy.arange(13, dtype=numpy.float64) + 0.5)
+    value = list(map(float, common.caget('CAS:Test', array=True)))
+    assert(value == [ i + 0.5 for i in range(13) ])
+
+    pv = server.createPV('CAS:TestInt', ca.Type.LONG, count=13)
+    common.store_attributes(pv)
+    # Outside of the range of a 16 bit integer
+    pv._pv.postValue(ca.Events.VALUE, (numpy.arange(13, dtype=numpy.int64) - 6) * 100000)
+    value = list(map(int, common.caget('CAS:TestInt', array=True)))
+    assert(value == [ i * 100000 for i in range(-6, 7) ])
+
+    # Non contiguous arrays use the numpy cast
+    pv._pv.postValue(ca.Events.VALUE, (numpy.arange(26, dtype=numpy.float64) * 100000 + 0.75)[::2])
+    value = list(map(int, common.caget('CAS:TestInt', array=True)))
+    assert(value == [ i * 100000 for i in range(0, 26, 2) ])
+
+def test_post_buffer(server):
+    import array
+
+    pv = server.createPV('CAS:Test', ca.Type.DOUBLE, count=100)
+    common.store_attributes(pv)
+    pv._pv.postValue(ca.Events.VALUE, array.array('d', range(100)))
+    value = list(map(float, common.caget('CAS:Test', array=True)))
+    assert(value == list(range(100)))
+
+    pv._pv.postValue(ca.Events.VALUE, memoryview(array.array('i', range(100))))
+    value = list(map(float, common.caget('CAS:Test', array=True)))
+    assert(value == list(range(100)))
+
+    # Read-only, writeable and non contiguous byte buffers
+    pv._pv.postValue(ca.Events.VALUE, bytes(range(100)))
+    value = list(map(float, common.caget('CAS:Test', array=True)))
+    assert(value == list(range(100)))
+
+    pv._pv.postValue(ca.Events.VALUE, bytearray(range(100)))
+    value = list(map(float, common.caget('CAS:Test', array=True)))
+    assert(value == list(range(100)))
+
+    pv._pv.postValue(ca.Events.VALUE, memoryview(bytearray(range(200)))[::2])
+    value = list(map(float, common.caget('CAS:Test', array=True)))
+    assert(value == list(range(0, 200, 2)))
+
+    # CHAR arrays reference bytes objects directly
+    pv = server.createPV('CAS:TestChar', ca.Type.CHAR, count=100)
+    common.store_attributes(pv)
+    pv._pv.postValue(ca.Events.VALUE, bytes(range(100)))
+    value = list(map(int, common.caget('CAS:TestChar', array=True)))
+    assert(value == list(range(100)))
+
+    pv._pv.postValue(ca.Events.VALUE, bytearray(range(100)))
+    value = list(map(int, common.caget('CAS:TestChar', array=True)))
+    assert(value == list(range(100)))
+
+def test_post_mixed_sequence(server):
+    class Float(float):
+        pass
+
+    pv = server.createPV('CAS:Test', ca.Type.DOUBLE, count=4)
+    common.store_attributes(pv)
+    pv._pv.postValue(ca.Events.VALUE, [ 1, 2.5, Float(3.5), True ])
+    value = list(map(float, common.caget('CAS:Test', array=True)))
+    assert(value == [ 1.0, 2.5, 3.5, 1.0 ])
+
+    pv = server.createPV('CAS:TestInt', ca.Type.LONG, count=4)
+    common.store_attributes(pv)
+    pv._pv.postValue(ca.Events.VALUE, ( -1, 2**20, 3, 3 ))
+    value = list(map(int, common.caget('CAS:TestInt', array=True)))
+    assert(value == [ -1, 2**20, 3, 3 ])
+
+def test_post_single_element(server):
+    import array
+
+    pv = server.createPV('CAS:Test', ca.Type.DOUBLE)
+    common.store_attributes(pv)
+    pv._pv.postValue(ca.Events.VALUE, [ 2.5 ])
+    assert(float(common.caget('CAS:Test')) == 2.5)
+
+    pv._pv.postValue(ca.Events.VALUE, array.array('d', [ 3.5 ]))
+    assert(float(common.caget('CAS:Test')) == 3.5)
+
+def test_value_events():
+    value_events = cas.cas.valueEvents
+    events = int(ca.Events.VALUE | ca.Events.ARCHIVE)
+
+    assert(value_events(1.0, 1.0, 1e-5, 1e-8, 0.0, 0.0) == (False, 0))
+    assert(value_events(1.0, 1.0 + 1e-9, 1e-5, 1e-8, 0.0, 0.0) == (False, 0))
+    assert(value_events(1, 2, 0.0, 0.0, 0.0, 0.0) == (True, events))
+    assert(value_events(1, 2, 0.0, 0.0, 0.5, 2.0) == (True, int(ca.Events.VALUE)))
+
+    old = tuple(float(i) for i in range(100))
+    new = old[:50] + (55.0,) + old[51:]
+    assert(value_events(new, old, 1e-5, 1e-8, 5.0, 6.0) == (True, int(ca.Events.VALUE)))
+    assert(value_events(old, old, 1e-5, 1e-8, 0.0, 0.0) == (False, 0))
+
+    nan = float('nan')
+    assert(value_events((1.0, nan), (1.0, nan), 1e-5, 1e-8, 0.0, 0.0) == (False, 0))
+    assert(value_events((1.0, nan), (1.0, 2.0), 1e-5, 1e-8, 100.0, 100.0) == (True, events))
+
+@pytest.mark.skipif(not cas.numpy, reason="No numpy support")
+def test_value_events_numpy():
+    import numpy
+    value_events = cas.cas.valueEvents
+
+    old = numpy.arange(1000, dtype=numpy.int32)
+    new = old.copy()
+    assert(value_events(new, old, 0.0, 0.0, 0.0, 0.0) == (False, 0))
+    new[999] = 0
+    assert(value_events(new, old, 0.0, 0.0, 500.0, 1000.0) == (True, int(ca.Events.VALUE)))
+    assert(value_events(new.astype(numpy.float32), old, 1e-5, 1e-8, 0.0, 0.0)[0])
@@ -83,6 +83,22 @@ def test_put_float_array_numpy(server, type_):
     assert(isinstance(pv.value, numpy.ndarray))
     assert(numpy.allclose(pv.value, test_values))
 
+@pytest.mark.skipif(not cas.numpy, reason="No numpy support")
+def test_put_array_numpy_view(server):
+    import numpy
+
+    test_values = 3.141 * numpy.arange(10)
+    written = []
+    def handler(pv, value, timestamp, context):
+        written.append(value)
+        return True
+    pv = server.createPV('CAS:Test', ca.Type.DOUBLE, count=len(test_values),
+        write_handler=handler, use_numpy=True, numpy_views=True)
+    common.caput('CAS:Test', test_values)
+    assert(isinstance(written[0], numpy.ndarray))
+    assert(not written[0].flags.writeable)
+    assert(numpy.allclose(written[0], test_values))
+
 @pytest.mark.skipif(not cas.numpy, reason="No numpy support")
 def test_put_enum_array_numpy(server):
     import numpy
@@ -0,0 +1,87 @@
+import os
+import sys
+import pytest
+import subprocess
+
+import channel_access.common as ca
+from . import common
+
+
+BACKEND_SCRIPT = '''
+import sys
+import channel_access.common as ca
+import channel_access.server as cas
+
+with cas.Server() as server:
+    pv = server.createPV(sys.argv[1], ca.Type.LONG)
+    pv.value = int(sys.argv[2])
+    print('ready', flush=True)
+    sys.stdin.read()
+'''
+
+def start_backend(port, name, value):
+    environment = os.environ.copy()
+    environment.update({
+        'EPICS_CAS_INTF_ADDR_LIST': common.EPICS_CA_ADDR,
+        'EPICS_CA_SERVER_PORT': str(port),
+        'EPICS_CAS_SERVER_PORT': str(port),
+        'EPICS_CA_REPEATER_PORT': common.EPICS_CA_REPEATER_PORT
+    })
+    proc = subprocess.Popen([ sys.executable, '-c', BACKEND_SCRIPT, name, str(value) ],
+        stdin=subprocess.PIPE,
+        stdout=subprocess.PIPE,
+        env=environment,
+        universal_newlines=True)
+    assert(proc.stdout.readline().strip() == 'ready')
+    return proc
+
+def stop_backend(proc):
+    proc.stdin.close()
+    proc.wait()
+
+
+def test_shard_prefix(server):
+    backends = [
+        start_backend(9125, 'CAS:A:Test', 1),
+        start_backend(9126, 'CAS:B:Test', 2)
+    ]
+    try:
+        server.addShardPrefix('CAS:A:', (common.EPICS_CA_ADDR, 9125))
+        server.addShardPrefix('CAS:B:', (common.EPICS_CA_ADDR, 9126))
+        assert(int(common.caget('CAS:A:Test', timeout=1)) == 1)
+        assert(int(common.caget('CAS:B:Test', timeout=1)) == 2)
+    finally:
+        for proc in backends:
+            stop_backend(proc)
+
+def test_shard_hashing(server):
+    names = [ 'CAS:Test{}'.format(i) for i in range(1000) ]
+    server.addShard(('127.0.0.1', 9125))
+    server.addShard(('127.0.0.1', 9126))
+    before = { name: server.shardFor(name) for name in names }
+    assert(set(before.values()) == { ('127.0.0.1', 9125), ('127.0.0.1', 9126) })
+
+    # Only names of the new shard move
+    server.addShard(('127.0.0.1', 9127))
+    after = { name: server.shardFor(name) for name in names }
+    for name in names:
+        assert(after[name] == before[name] or after[name] == ('127.0.0.1', 9127))
+
+    # The prefix rule takes precedence
+    server.addShardPrefix('CAS:', ('127.0.0.1', 9128))
+    assert(server.shardFor('CAS:Test1') == ('127.0.0.1', 9128))
+
+def test_shard_local_names_first(server):
+    pvs = {}
+    def exist_handler(server, name, context):
+        return name == 'CAS:Local'
+
+    def attach_handler(server, name, context):
+        pvs[name] = server.createPV(name, ca.Type.LONG, attributes={ 'value': 3 })
+        return pvs[name]
+
+    server.exist_handler = exist_handler
+    server.attach_handler = attach_handler
+    # Every name hashes to the (not running) backend
+    server.addShard(('127.0.0.1', 9125))
+    assert(int(common.caget('CAS:Local', timeout=1)) == 3)